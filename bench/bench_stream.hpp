@@ -0,0 +1,33 @@
+#ifndef SPEC_TAGE_SC_L_BENCH_BENCH_STREAM_HPP_
+#define SPEC_TAGE_SC_L_BENCH_BENCH_STREAM_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "tagescl/synthetic_stream.hpp"
+#include "tagescl/utils.hpp"
+
+// The stream the benchmarks run on: loops, correlated chains, indirect jumps,
+// calls and returns and noise branches, with the default weights of
+// tagescl::Synthetic_Stream_Config.
+inline std::vector<tagescl::Branch_Record> MakeStream(
+    std::size_t numBranches, std::uint64_t seed = 1) {
+  tagescl::Synthetic_Stream_Config config;
+  config.seed = seed;
+  return tagescl::Synthetic_Branch_Stream(config).generate(numBranches);
+}
+
+// The conditional branches of stream, for the benchmarks of the
+// prediction-side functions.
+inline std::vector<tagescl::Branch_Record> ConditionalBranches(
+    const std::vector<tagescl::Branch_Record>& stream) {
+  std::vector<tagescl::Branch_Record> conditional;
+  for (const auto& br : stream) {
+    if (br.br_type.is_conditional) {
+      conditional.push_back(br);
+    }
+  }
+  return conditional;
+}
+
+#endif  // SPEC_TAGE_SC_L_BENCH_BENCH_STREAM_HPP_
@@ -0,0 +1,476 @@
+// Microbenchmarks of the hot paths of the predictor components, run on a
+// synthetic branch stream. Every benchmark reports the time per branch (or per
+// flush) in the "per_branch" counter. Benchmarks of prediction-side functions
+// only count the conditional branches of the stream.
+//
+// The components are warmed up with the stream before timing. Some
+// benchmarks must also advance the histories to make progress, so their time
+// includes BM_TagePushIntoHistory; subtract it to isolate the rest.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "bench_stream.hpp"
+#include "tagescl/tagescl.hpp"
+
+namespace {
+
+constexpr std::size_t kStreamSize = 1 << 16;
+constexpr int kMaxInFlightBranches = 512;
+
+const std::vector<tagescl::Branch_Record>& Stream() {
+  static const auto stream = MakeStream(kStreamSize);
+  return stream;
+}
+
+const std::vector<tagescl::Branch_Record>& ConditionalStream() {
+  static const auto stream = ConditionalBranches(Stream());
+  return stream;
+}
+
+// The components of a Tage_SC_L, which keeps them private.
+template <class CONFIG>
+struct Components {
+  Components()
+      : tage(rng, kMaxInFlightBranches), statisticalCorrector(), loop(rng) {}
+
+  tagescl::Random_Number_Generator rng;
+  tagescl::Tage<typename CONFIG::TAGE> tage;
+  tagescl::Statistical_Corrector<CONFIG> statisticalCorrector;
+  tagescl::Loop_Predictor<typename CONFIG::LOOP> loop;
+};
+
+// Runs br through TAGE without anything else in flight.
+template <class TAGE_CONFIG>
+void TageProcess(tagescl::Tage<TAGE_CONFIG>& tage,
+                 const tagescl::Branch_Record& br,
+                 tagescl::Tage_Prediction_Info<TAGE_CONFIG>* info) {
+  if (br.br_type.is_conditional) {
+    tage.get_prediction(br.br_pc, info);
+  }
+  tage.update_speculative_state(br.br_pc, br.br_target, br.br_type,
+                                br.resolve_dir, info);
+  if (br.br_type.is_conditional) {
+    tage.commit_state(br.br_pc, br.resolve_dir, *info, info->prediction);
+  }
+  tage.commit_state_at_retire(*info);
+}
+
+template <class CONFIG>
+std::unique_ptr<Components<CONFIG>> WarmComponents() {
+  auto components = std::make_unique<Components<CONFIG>>();
+  tagescl::Tage_Prediction_Info<typename CONFIG::TAGE> info;
+  for (const auto& br : Stream()) {
+    TageProcess(components->tage, br, &info);
+  }
+  return components;
+}
+
+void SetBranchCounter(benchmark::State& state, std::size_t branchesPerIter) {
+  state.counters["per_branch"] = benchmark::Counter(
+      static_cast<double>(branchesPerIter),
+      benchmark::Counter::kIsIterationInvariantRate |
+          benchmark::Counter::kInvert);
+}
+
+// Predictions with fixed histories: only the pc changes between lookups.
+template <class CONFIG>
+void BM_TageGetPrediction(benchmark::State& state) {
+  auto components = WarmComponents<CONFIG>();
+  tagescl::Tage_Prediction_Info<typename CONFIG::TAGE> info;
+  const auto& stream = ConditionalStream();
+  for (auto _ : state) {
+    for (const auto& br : stream) {
+      components->tage.get_prediction(br.br_pc, &info);
+      benchmark::DoNotOptimize(info.prediction);
+    }
+  }
+  SetBranchCounter(state, stream.size());
+}
+
+// The indices and tags of the tagged tables, with fixed histories. They are
+// computed by Tage::prefetch(), which only adds a prefetch per table.
+template <class CONFIG>
+void BM_TageIndicesTags(benchmark::State& state) {
+  auto components = WarmComponents<CONFIG>();
+  tagescl::Tage_Prediction_Info<typename CONFIG::TAGE> info;
+  const auto& stream = ConditionalStream();
+  for (auto _ : state) {
+    for (const auto& br : stream) {
+      components->tage.prefetch(br.br_pc, &info);
+      benchmark::DoNotOptimize(info.indices);
+      benchmark::DoNotOptimize(info.tags);
+    }
+  }
+  SetBranchCounter(state, stream.size());
+}
+
+// The indices and tags as fill_table_indices_tags() computed them before the
+// hash parameters were precomputed: a runtime loop over the tables, with the
+// shifts, masks and rotations recomputed for every table and the bank of
+// each table found with a running counter. Interleaved pairs are left out, as
+// the benchmarked configurations do not use them.
+template <class TAGE_CONFIG>
+void LoopFillIndicesTags(const tagescl::Tage_Histories<TAGE_CONFIG>& histories,
+                         std::uint64_t brPc, int* indices, int* tags) {
+  constexpr int kLogEntries = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
+  constexpr int kNumTables = 2 * TAGE_CONFIG::NUM_HISTORIES;
+  constexpr tagescl::Tage_Tables_Enabled<TAGE_CONFIG> kTablesEnabled = {};
+  constexpr tagescl::Tage_History_Sizes<TAGE_CONFIG> kHistorySizes = {};
+  constexpr tagescl::Tage_Tag_Bits<TAGE_CONFIG> kTagBits = {};
+  auto pathHash = [](std::int64_t pathHistory, int maxWidth, int bank) {
+    pathHistory &= (1 << maxWidth) - 1;
+    std::int64_t low = pathHistory & ((1 << kLogEntries) - 1);
+    std::int64_t high = pathHistory >> kLogEntries;
+    if (bank < kLogEntries) {
+      high = ((high << bank) & ((1 << kLogEntries) - 1)) +
+             (high >> (kLogEntries - bank));
+    }
+    pathHistory = low ^ high;
+    if (bank < kLogEntries) {
+      pathHistory = ((pathHistory << bank) & ((1 << kLogEntries) - 1)) +
+                    (pathHistory >> (kLogEntries - bank));
+    }
+    return pathHistory;
+  };
+  for (int i = 1; i <= kNumTables; i += 2) {
+    if (!kTablesEnabled.arr[i] && !kTablesEnabled.arr[i + 1]) continue;
+    int j = (i - 1) / 2;
+    int maxPathWidth =
+        std::min(kHistorySizes.arr[j], TAGE_CONFIG::PATH_HISTORY_WIDTH);
+    std::int64_t index = brPc;
+    index ^= brPc >> (std::abs(kLogEntries - i) + 1);
+    index ^= histories.folded_history_for_indices(j);
+    index ^= pathHash(histories.path_history_, maxPathWidth, i);
+    indices[i] = index & ((1 << kLogEntries) - 1);
+    std::int64_t tag = brPc;
+    tag ^= histories.folded_history_for_tags_0(j);
+    tag ^= histories.folded_history_for_tags_1(j) << 1;
+    tags[i] = tag & ((1 << kTagBits.arr[j]) - 1);
+    tags[i + 1] = tags[i];
+    indices[i + 1] = indices[i] ^ (tags[i] & ((1 << kLogEntries) - 1));
+  }
+  auto addBanks = [&](int first, int last, int bank, int numBanks) {
+    for (int i = first; i <= last; ++i) {
+      if (kTablesEnabled.arr[i]) {
+        indices[i] += bank << kLogEntries;
+        bank = (bank + 1) % numBanks;
+      }
+    }
+  };
+  std::int64_t pathHistory = histories.path_history_;
+  int longHistoryWidth =
+      kHistorySizes.arr[(TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1) / 2];
+  addBanks(TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE, kNumTables,
+           (brPc ^ (pathHistory & ((std::int64_t(1) << longHistoryWidth) -
+                                   1))) %
+               TAGE_CONFIG::LONG_HISTORY_NUM_BANKS,
+           TAGE_CONFIG::LONG_HISTORY_NUM_BANKS);
+  addBanks(1, TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1,
+           (brPc ^ (pathHistory & ((1 << kHistorySizes.arr[0]) - 1))) %
+               TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS,
+           TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS);
+}
+
+// The baseline of BM_TageIndicesTags: LoopFillIndicesTags() on histories
+// warmed with the same stream, followed by a prefetch per enabled table and
+// one for the bimodal table, like Tage::prefetch().
+template <class CONFIG>
+void BM_TageIndicesTagsLoop(benchmark::State& state) {
+  using TAGE_CONFIG = typename CONFIG::TAGE;
+  constexpr int kNumTables = 2 * TAGE_CONFIG::NUM_HISTORIES;
+  constexpr tagescl::Tage_Tables_Enabled<TAGE_CONFIG> kTablesEnabled = {};
+  auto histories =
+      std::make_unique<tagescl::Tage_Histories<TAGE_CONFIG>>(
+          kMaxInFlightBranches);
+  tagescl::Tage_Prediction_Info<TAGE_CONFIG> info;
+  for (const auto& br : Stream()) {
+    histories->push_into_history(br.br_pc, br.br_target, br.br_type,
+                                 br.resolve_dir, &info);
+  }
+  std::vector<std::uint16_t> table(
+      std::max(TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS,
+               TAGE_CONFIG::LONG_HISTORY_NUM_BANKS)
+      << TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
+  std::vector<std::uint8_t> bimodal(
+      1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE);
+  int indices[kNumTables + 1];
+  int tags[kNumTables + 1];
+  const auto& stream = ConditionalStream();
+  for (auto _ : state) {
+    for (const auto& br : stream) {
+      LoopFillIndicesTags(*histories, br.br_pc, indices, tags);
+      for (int i = 1; i <= kNumTables; ++i) {
+        if (kTablesEnabled.arr[i]) {
+          __builtin_prefetch(&table[indices[i]]);
+        }
+      }
+      __builtin_prefetch(
+          &bimodal[(br.br_pc ^ (br.br_pc >> 2)) & (bimodal.size() - 1)]);
+      benchmark::DoNotOptimize(indices);
+      benchmark::DoNotOptimize(tags);
+    }
+  }
+  SetBranchCounter(state, stream.size());
+}
+
+// Tage::update_speculative_state() only calls push_into_history().
+template <class CONFIG>
+void BM_TagePushIntoHistory(benchmark::State& state) {
+  auto components = WarmComponents<CONFIG>();
+  tagescl::Tage_Prediction_Info<typename CONFIG::TAGE> info;
+  const auto& stream = Stream();
+  for (auto _ : state) {
+    for (const auto& br : stream) {
+      components->tage.update_speculative_state(br.br_pc, br.br_target,
+                                                br.br_type, br.resolve_dir,
+                                                &info);
+      components->tage.commit_state_at_retire(info);
+    }
+  }
+  SetBranchCounter(state, stream.size());
+}
+
+// The bits that push_into_history() inserts into the global history for br.
+int NumHistoryBits(const tagescl::Branch_Record& br) {
+  return br.br_type.is_indirect && !br.br_type.is_conditional ? 3 : 2;
+}
+std::uint64_t HistoryBits(const tagescl::Branch_Record& br) {
+  return br.br_pc ^ (br.br_pc >> 2) ^ br.resolve_dir;
+}
+
+// Runs the stream through two copies of the folded histories of TAGE, one
+// updated with update() and update_reverse(), which use SIMD when the target
+// has AVX2 or AVX-512, and one with the scalar implementation. One in four
+// branches is also rewound. Returns false if any fold ever differs.
+template <class TAGE_CONFIG>
+bool FoldedHistoriesMatchScalar() {
+  constexpr int kNumFolds = 3 * TAGE_CONFIG::NUM_HISTORIES;
+  auto histories =
+      std::make_unique<tagescl::Tage_Histories<TAGE_CONFIG>>(
+          kMaxInFlightBranches);
+  auto& history = histories->history_register_;
+  auto simd = histories->folded_histories_;
+  auto scalar = histories->folded_histories_;
+  auto same = [&] {
+    for (int fold = 0; fold < kNumFolds; ++fold) {
+      if (simd.get_value(fold) != scalar.get_value(fold)) return false;
+    }
+    return true;
+  };
+  for (std::size_t i = 0; i < Stream().size(); ++i) {
+    const auto& br = Stream()[i];
+    int numBits = NumHistoryBits(br);
+    history.push_bits(HistoryBits(br), numBits);
+    simd.update(history, numBits);
+    scalar.template update_all_scalar<false>(history, numBits);
+    if (!same()) return false;
+    if (i % 4 == 3) {
+      simd.update_reverse(history, numBits);
+      scalar.template update_all_scalar<true>(history, numBits);
+      history.rewind(numBits);
+      if (!same()) return false;
+    } else {
+      history.retire(numBits);
+    }
+  }
+  return true;
+}
+
+// Folds the history bits of every branch of the stream into the folded
+// histories of TAGE, with update() or, if scalar, always with the scalar
+// implementation. Both are first checked to give the same folds.
+template <class CONFIG, bool scalar>
+void BM_FoldedHistoryUpdate(benchmark::State& state) {
+  using TAGE_CONFIG = typename CONFIG::TAGE;
+  if (!FoldedHistoriesMatchScalar<TAGE_CONFIG>()) {
+    state.SkipWithError("The SIMD and scalar folded histories differ");
+    return;
+  }
+  auto histories =
+      std::make_unique<tagescl::Tage_Histories<TAGE_CONFIG>>(
+          kMaxInFlightBranches);
+  auto& history = histories->history_register_;
+  auto& folded = histories->folded_histories_;
+  const auto& stream = Stream();
+  for (auto _ : state) {
+    for (const auto& br : stream) {
+      int numBits = NumHistoryBits(br);
+      history.push_bits(HistoryBits(br), numBits);
+      if (scalar) {
+        folded.template update_all_scalar<false>(history, numBits);
+      } else {
+        folded.update(history, numBits);
+      }
+      history.retire(numBits);
+    }
+    benchmark::DoNotOptimize(folded);
+  }
+  SetBranchCounter(state, stream.size());
+}
+
+void FlushDepths(benchmark::internal::Benchmark* benchmark) {
+  for (int depth : {1, 8, 32, 128}) {
+    benchmark->Arg(depth);
+  }
+}
+
+// Pushes state.range(0) branches and flushes all of them. The reported time
+// is per flush, including the pushes. The Checkpointed configurations restore
+// the folded histories instead of rewinding them.
+template <class CONFIG>
+using Checkpointed = tagescl::With_Folded_History_Checkpoints<CONFIG>;
+
+template <class CONFIG>
+void BM_TageRecover(benchmark::State& state) {
+  auto components = WarmComponents<CONFIG>();
+  const int depth = static_cast<int>(state.range(0));
+  std::vector<tagescl::Tage_Prediction_Info<typename CONFIG::TAGE>> infos(
+      depth);
+  const auto& stream = Stream();
+  std::size_t next = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < depth; ++i) {
+      const auto& br = stream[(next + i) % stream.size()];
+      components->tage.update_speculative_state(br.br_pc, br.br_target,
+                                                br.br_type, br.resolve_dir,
+                                                &infos[i]);
+    }
+    components->tage.global_recover_speculative_state(infos[0]);
+    // The oldest branch takes the other direction and retires.
+    const auto& br = stream[next % stream.size()];
+    components->tage.update_speculative_state(br.br_pc, br.br_target,
+                                              br.br_type, !br.resolve_dir,
+                                              &infos[0]);
+    components->tage.commit_state_at_retire(infos[0]);
+    next += depth;
+  }
+  SetBranchCounter(state, 1);
+}
+
+// The TAGE predictions the statistical corrector sees, for the first
+// kScBranches branches of the stream. The time is per branch, conditional or
+// not.
+constexpr std::size_t kScBranches = 1 << 13;
+
+template <class CONFIG>
+struct ScFixture {
+  ScFixture() : components(std::make_unique<Components<CONFIG>>()) {
+    tageInfos.resize(kScBranches);
+    const auto& stream = Stream();
+    for (std::size_t i = 0; i < kScBranches; ++i) {
+      TageProcess(components->tage, stream[i], &tageInfos[i]);
+    }
+    // Warm up the statistical corrector.
+    for (int i = 0; i < 4; ++i) {
+      Run(true);
+    }
+  }
+
+  void Run(bool commit) {
+    const auto& stream = Stream();
+    tagescl::SC_Prediction_Info info;
+    for (std::size_t i = 0; i < kScBranches; ++i) {
+      const auto& br = stream[i];
+      const auto& tageInfo = tageInfos[i];
+      auto& sc = components->statisticalCorrector;
+      if (br.br_type.is_conditional) {
+        sc.get_prediction(br.br_pc, tageInfo, tageInfo.prediction, &info);
+        benchmark::DoNotOptimize(info.prediction);
+      }
+      sc.update_speculative_state(br.br_pc, br.resolve_dir, br.br_target,
+                                  br.br_type, &info);
+      if (commit && br.br_type.is_conditional) {
+        sc.commit_state(br.br_pc, br.resolve_dir, tageInfo, info,
+                        tageInfo.prediction);
+      }
+    }
+  }
+
+  std::unique_ptr<Components<CONFIG>> components;
+  std::vector<tagescl::Tage_Prediction_Info<typename CONFIG::TAGE>> tageInfos;
+};
+
+// get_prediction() and update_speculative_state() of the statistical
+// corrector.
+template <class CONFIG>
+void BM_ScGetPrediction(benchmark::State& state) {
+  ScFixture<CONFIG> fixture;
+  for (auto _ : state) {
+    fixture.Run(false);
+  }
+  SetBranchCounter(state, kScBranches);
+}
+
+// Same as BM_ScGetPrediction, plus commit_state().
+template <class CONFIG>
+void BM_ScCommitState(benchmark::State& state) {
+  ScFixture<CONFIG> fixture;
+  for (auto _ : state) {
+    fixture.Run(true);
+  }
+  SetBranchCounter(state, kScBranches);
+}
+
+template <class CONFIG>
+void BM_LoopPredictor(benchmark::State& state) {
+  auto components = WarmComponents<CONFIG>();
+  tagescl::Loop_Prediction_Info<typename CONFIG::LOOP> info;
+  const auto& stream = ConditionalStream();
+  for (auto _ : state) {
+    for (const auto& br : stream) {
+      components->loop.get_prediction(br.br_pc, &info);
+      benchmark::DoNotOptimize(info.prediction);
+      components->loop.update_speculative_state(info);
+      components->loop.commit_state(br.br_pc, br.resolve_dir, info,
+                                    info.valid && info.prediction !=
+                                                      br.resolve_dir,
+                                    br.resolve_dir);
+    }
+  }
+  SetBranchCounter(state, stream.size());
+}
+
+// The whole predictor, for reference.
+template <class CONFIG>
+void BM_TageSclUpdateBatch(benchmark::State& state) {
+  auto predictor = std::make_unique<tagescl::Tage_SC_L<CONFIG>>(2);
+  const auto& stream = Stream();
+  predictor->update_batch(stream.data(), stream.size());
+  for (auto _ : state) {
+    predictor->update_batch(stream.data(), stream.size());
+  }
+  SetBranchCounter(state, stream.size());
+}
+
+}  // namespace
+
+#define TAGESCL_BENCHMARK(name)                    \
+  BENCHMARK_TEMPLATE(name, tagescl::CONFIG_64KB); \
+  BENCHMARK_TEMPLATE(name, tagescl::CONFIG_80KB)
+
+TAGESCL_BENCHMARK(BM_TageGetPrediction);
+TAGESCL_BENCHMARK(BM_TageIndicesTags);
+TAGESCL_BENCHMARK(BM_TageIndicesTagsLoop);
+TAGESCL_BENCHMARK(BM_TagePushIntoHistory);
+BENCHMARK_TEMPLATE(BM_FoldedHistoryUpdate, tagescl::CONFIG_64KB, false);
+BENCHMARK_TEMPLATE(BM_FoldedHistoryUpdate, tagescl::CONFIG_64KB, true);
+BENCHMARK_TEMPLATE(BM_FoldedHistoryUpdate, tagescl::CONFIG_80KB, false);
+BENCHMARK_TEMPLATE(BM_FoldedHistoryUpdate, tagescl::CONFIG_80KB, true);
+BENCHMARK_TEMPLATE(BM_TageRecover, tagescl::CONFIG_64KB)->Apply(FlushDepths);
+BENCHMARK_TEMPLATE(BM_TageRecover, tagescl::CONFIG_80KB)->Apply(FlushDepths);
+BENCHMARK_TEMPLATE(BM_TageRecover, Checkpointed<tagescl::CONFIG_64KB>)
+    ->Apply(FlushDepths);
+BENCHMARK_TEMPLATE(BM_TageRecover, Checkpointed<tagescl::CONFIG_80KB>)
+    ->Apply(FlushDepths);
+TAGESCL_BENCHMARK(BM_ScGetPrediction);
+TAGESCL_BENCHMARK(BM_ScCommitState);
+TAGESCL_BENCHMARK(BM_LoopPredictor);
+TAGESCL_BENCHMARK(BM_TageSclUpdateBatch);
+
+BENCHMARK_MAIN();
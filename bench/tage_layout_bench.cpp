@@ -0,0 +1,70 @@
+// Compares the number of tagged-table cache lines that a TAGE prediction reads
+// with the default layout and with INTERLEAVE_2WAY_TABLES.
+//
+// Usage: tage_layout_bench [num_branches] [seed]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_stream.hpp"
+#include "tagescl/tagescl.hpp"
+
+template <class TAGE_CONFIG>
+struct InterleavedTageConfig : TAGE_CONFIG {
+  static constexpr bool INTERLEAVE_2WAY_TABLES = true;
+};
+
+template <class TAGE_CONFIG>
+void Run(const std::string& name,
+         const std::vector<tagescl::Branch_Record>& stream) {
+  tagescl::Random_Number_Generator rng;
+  auto tage = std::make_unique<tagescl::Tage<TAGE_CONFIG>>(rng, 1);
+  tagescl::Tage_Prediction_Info<TAGE_CONFIG> info;
+  std::int64_t numLines = 0;
+  std::int64_t numConditional = 0;
+  std::int64_t mispredictions = 0;
+  auto startTime = std::chrono::steady_clock::now();
+  for (const auto& br : stream) {
+    if (br.br_type.is_conditional) {
+      tage->get_prediction(br.br_pc, &info);
+      numLines += tage->num_tagged_cache_lines(info);
+      mispredictions += info.prediction != br.resolve_dir;
+      ++numConditional;
+    }
+    tage->update_speculative_state(br.br_pc, br.br_target, br.br_type,
+                                   br.resolve_dir, &info);
+    if (br.br_type.is_conditional) {
+      tage->commit_state(br.br_pc, br.resolve_dir, info, br.resolve_dir);
+    }
+    tage->commit_state_at_retire(info);
+  }
+  auto endTime = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(endTime - startTime)
+                  .count();
+  std::cout << std::left << std::setw(24) << name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(8)
+            << static_cast<double>(numLines) / numConditional << " lines/pred"
+            << std::setw(10) << ns / stream.size() << " ns/branch"
+            << std::setw(10)
+            << 1000.0 * mispredictions / numConditional << " misp/Kbr\n";
+}
+
+int main(int argc, char** argv) {
+  std::size_t numBranches = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                     : 2000000;
+  std::uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+  auto stream = MakeStream(numBranches, seed);
+  Run<tagescl::CONFIG_64KB::TAGE>("64KB", stream);
+  Run<InterleavedTageConfig<tagescl::CONFIG_64KB::TAGE>>("64KB interleaved",
+                                                          stream);
+  Run<tagescl::CONFIG_80KB::TAGE>("80KB", stream);
+  Run<InterleavedTageConfig<tagescl::CONFIG_80KB::TAGE>>("80KB interleaved",
+                                                          stream);
+  return 0;
+}
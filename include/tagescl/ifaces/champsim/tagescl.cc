@@ -2,43 +2,115 @@
 #include <cstdint>
 
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include "ooo_cpu.h"
 #include "tagescl/tagescl.hpp"
 
-struct ChampsimTageScl {
-  using Impl = tagescl::Tage_SC_L<tagescl::CONFIG_64KB>;
+// Define TAGE_SC_L_SIZE to 80 to simulate the 80KB configuration.
+#ifndef TAGE_SC_L_SIZE
+#define TAGE_SC_L_SIZE 64
+#endif
+
+#if TAGE_SC_L_SIZE == 64
+using Config = tagescl::CONFIG_64KB;
+#elif TAGE_SC_L_SIZE == 80
+using Config = tagescl::CONFIG_80KB;
+#else
+#error Unsupported TAGE_SC_L_SIZE setting.
+#endif
+
+// Define TAGE_SC_L_PIPELINE_DEPTH to N > 0 to keep the last N branches in
+// flight: a branch updates the speculative histories with its prediction, is
+// repaired right away if it was mispredicted, and commits when N younger
+// branches have been predicted. With 0, every branch commits right after its
+// result.
+#ifndef TAGE_SC_L_PIPELINE_DEPTH
+#define TAGE_SC_L_PIPELINE_DEPTH 0
+#endif
+
+static_assert(TAGE_SC_L_PIPELINE_DEPTH >= 0,
+              "TAGE_SC_L_PIPELINE_DEPTH cannot be negative");
+
+// The predictor of a core. Each one is allocated on its own and aligned to a
+// cache line, so the cores never write to the same line.
+struct alignas(64) ChampsimTageScl {
+  using Impl = tagescl::Tage_SC_L<Config>;
   enum State {
     NONE,
     PREDICTED,
   };
 
-  ChampsimTageScl(std::size_t max_inflight_branches)
-      : impl(max_inflight_branches), id(0), state(NONE) {}
+  static constexpr std::uint32_t pipeline_depth = TAGE_SC_L_PIPELINE_DEPTH;
+
+  // A branch whose result is known, waiting to be committed.
+  struct In_Flight_Branch {
+    std::uint64_t ip;
+    std::uint64_t target;
+    tagescl::Branch_Type type;
+    bool taken;
+  };
+
+  ChampsimTageScl()
+      : impl(pipeline_depth + 1),
+        id(0),
+        state(NONE),
+        in_flight(in_flight_size()),
+        oldest_id(0),
+        num_in_flight(0) {}
+
+  // The ids of the branches in flight are consecutive, so a branch owns the
+  // entry at its id modulo the size, a power of two. A new branch enters
+  // before the oldest one leaves.
+  static std::size_t in_flight_size() {
+    std::size_t size = 1;
+    while (size < pipeline_depth + 1) size <<= 1;
+    return size;
+  }
+
+  In_Flight_Branch& in_flight_branch(std::uint32_t branch_id) {
+    return in_flight[branch_id & (in_flight.size() - 1)];
+  }
 
   Impl impl;
   std::uint64_t last_ip;
   std::uint32_t id;
   State state;
+  bool last_prediction;
+  // Only used if pipeline_depth > 0.
+  std::vector<In_Flight_Branch> in_flight;
+  std::uint32_t oldest_id;
+  std::uint32_t num_in_flight;
 };
 
-static std::vector<const O3_CPU*> cpus;
-static std::vector<ChampsimTageScl> predictors;
+// Indexed by O3_CPU::cpu. The predictors cannot be moved, since they hold
+// pointers to their own tables.
+static std::vector<std::unique_ptr<ChampsimTageScl>> predictors;
 
 static ChampsimTageScl& get_predictor(const O3_CPU* cpu) {
-  for (std::size_t i = 0; i < cpus.size(); ++i) {
-    if (cpus[i] == cpu) return predictors[i];
-  }
-  assert(false);
+  assert(cpu->cpu < predictors.size() && predictors[cpu->cpu]);
+  return *predictors[cpu->cpu];
 }
 
 void O3_CPU::initialize_branch_predictor() {
-  cpus.push_back(this);
-  predictors.emplace_back(1);
+  if (predictors.size() <= cpu) {
+    predictors.resize(cpu + 1);
+  }
+  predictors[cpu] = std::make_unique<ChampsimTageScl>();
 }
 
 std::uint8_t O3_CPU::predict_branch(std::uint64_t ip) {
   ChampsimTageScl& predictor = get_predictor(this);
+  if (ChampsimTageScl::pipeline_depth > 0 &&
+      predictor.state == ChampsimTageScl::PREDICTED) {
+    // The last ip was not a branch. Its id is still the youngest one and the
+    // speculative state has not changed since, so it is predicted again.
+    predictor.last_prediction =
+        predictor.impl.get_prediction(predictor.id, ip);
+    predictor.last_ip = ip;
+    return predictor.last_prediction;
+  }
   if (predictor.state == ChampsimTageScl::PREDICTED) {
     // If we get here is because last_branch_result was not called.
     // Hence, the last ip was not branch and we should retire it
@@ -51,10 +123,42 @@ std::uint8_t O3_CPU::predict_branch(std::uint64_t ip) {
                                           0, 0);
   }
   predictor.id = predictor.impl.get_new_branch_id();
-  bool prediction = predictor.impl.get_prediction(predictor.id, ip);
+  predictor.last_prediction = predictor.impl.get_prediction(predictor.id, ip);
   predictor.last_ip = ip;
   predictor.state = ChampsimTageScl::PREDICTED;
-  return prediction;
+  return predictor.last_prediction;
+}
+
+// Speculates on the predicted branch, repairs it if it was mispredicted and
+// commits the oldest branch in flight if there are more than pipeline_depth.
+static void pipeline_branch_result(ChampsimTageScl* predictor,
+                                   std::uint64_t ip, std::uint64_t target,
+                                   bool taken, tagescl::Branch_Type type) {
+  std::uint32_t id = predictor->id;
+  bool speculative_dir = type.is_conditional ? predictor->last_prediction : 1;
+  predictor->impl.update_speculative_state(id, ip, type, speculative_dir,
+                                           target);
+  if (speculative_dir != taken) {
+    predictor->impl.flush_branch_and_repair_state(id, ip, type, taken, target);
+  }
+  if (predictor->num_in_flight == 0) {
+    predictor->oldest_id = id;
+  }
+  predictor->in_flight_branch(id) = {ip, target, type, taken};
+  predictor->num_in_flight += 1;
+  if (predictor->num_in_flight > ChampsimTageScl::pipeline_depth) {
+    std::uint32_t oldest_id = predictor->oldest_id;
+    const ChampsimTageScl::In_Flight_Branch& oldest =
+        predictor->in_flight_branch(oldest_id);
+    if (oldest.type.is_conditional) {
+      predictor->impl.commit_state(oldest_id, oldest.ip, oldest.type,
+                                   oldest.taken);
+    }
+    predictor->impl.commit_state_at_retire(oldest_id, oldest.ip, oldest.type,
+                                           oldest.taken, oldest.target);
+    predictor->oldest_id += 1;
+    predictor->num_in_flight -= 1;
+  }
 }
 
 void O3_CPU::last_branch_result(std::uint64_t ip, std::uint64_t target,
@@ -68,6 +172,11 @@ void O3_CPU::last_branch_result(std::uint64_t ip, std::uint64_t target,
   type.is_indirect =
       branch_type == BRANCH_INDIRECT or branch_type == BRANCH_INDIRECT_CALL or
       branch_type == BRANCH_RETURN or branch_type == BRANCH_OTHER;
+  if (ChampsimTageScl::pipeline_depth > 0) {
+    pipeline_branch_result(&predictor, ip, target, taken, type);
+    predictor.state = ChampsimTageScl::NONE;
+    return;
+  }
   predictor.impl.update_speculative_state(predictor.id, ip, type, taken,
                                           target);
   if (type.is_conditional) {
@@ -1,5 +1,16 @@
 # Add the following to the BranchPredictor.py
-class TAGE_SCL(BranchPredictor):
-    type = "TAGE_SCL"
+class TAGE_SC_L(BranchPredictor):
+    type = "TAGE_SC_L"
     cxx_class = "gem5::branch_prediction::TAGE_SC_L"
     cxx_header = "cpu/pred/tage_sc_l.hh"
+
+    max_in_flight_branches = Param.Unsigned(
+        1024,
+        "Maximum number of branches predicted and not yet committed or "
+        "squashed (at least the ROB size plus the fetch and decode queues)",
+    )
+    smt_partitioned_tables = Param.Bool(
+        False,
+        "Give each hardware thread a predictor of its own instead of sharing "
+        "the tables and keeping only the speculative state per thread",
+    )
@@ -13,8 +13,38 @@ namespace gem5
 namespace branch_prediction
 {
 
-TAGE_SC_L::TAGE_SC_L(const TAGE_SC_LParams &params) : BPredUnit(params), tage(1024)
+namespace
 {
+
+uint32_t
+poolSize(unsigned max_in_flight_branches)
+{
+    fatal_if(max_in_flight_branches == 0,
+             "TAGE_SC_L needs max_in_flight_branches > 0");
+    uint32_t size = 1;
+    while (size < max_in_flight_branches) {
+        size <<= 1;
+    }
+    return size;
+}
+
+} // anonymous namespace
+
+TAGE_SC_L::TAGE_SC_L(const TAGE_SC_LParams &params)
+    : BPredUnit(params),
+      partitionedTables(params.smt_partitioned_tables),
+      branchInfoPool(numThreads * poolSize(params.max_in_flight_branches)),
+      branchInfoMask(poolSize(params.max_in_flight_branches) - 1)
+{
+    if (partitionedTables) {
+        for (unsigned tid = 0; tid < numThreads; ++tid) {
+            tages.push_back(
+                std::make_unique<Predictor>(params.max_in_flight_branches));
+        }
+    } else {
+        tages.push_back(std::make_unique<Predictor>(
+            params.max_in_flight_branches, numThreads));
+    }
 }
 
 // PREDICTOR UPDATE
@@ -27,6 +57,7 @@ TAGE_SC_L::update(ThreadID tid, Addr pc, bool taken, void * &bp_history,
     DPRINTF(Tage, "TAGE id:%d update: %lx squashed:%s bp_history:%p\n", bi ? bi->id : -1, pc, squashed, bp_history);
 
     assert(bp_history);
+    Predictor &tage = threadPredictor(tid);
     if (squashed) {
         // This restores the global history, then update it
         // and recomputes the folded histories.
@@ -36,7 +67,6 @@ TAGE_SC_L::update(ThreadID tid, Addr pc, bool taken, void * &bp_history,
 
     tage.commit_state(bi->id, pc, bi->br_type, taken);
     tage.commit_state_at_retire(bi->id, pc, bi->br_type, taken, target);
-    delete bi;
     bp_history = nullptr;
 }
 
@@ -47,17 +77,17 @@ TAGE_SC_L::squash(ThreadID tid, void * &bp_history)
     DPRINTF(Tage, "TAGE id: %d squash: %lx bp_history:%p\n", bi ? bi->id : -1,
         bi? bi->pc : 0x00, bp_history);
     if (bi) {
-      tage.flush_branch(bi->id);
+      threadPredictor(tid).flush_branch(bi->id);
     }
-    delete bi;
     bp_history = nullptr;
 }
 
 bool
 TAGE_SC_L::predict(ThreadID tid, Addr pc, bool cond_branch, void* &b)
 {
+    Predictor &tage = threadPredictor(tid);
     uint32_t id = tage.get_new_branch_id();
-    TageSclBranchInfo *bi = new TageSclBranchInfo();
+    TageSclBranchInfo *bi = allocBranchInfo(tid, id);
     b = (void*)(bi);
     DPRINTF(Tage, "TAGE id: %d predict: %lx bp_history:%p\n", id, pc, b);
     bi->id = id;
@@ -95,7 +125,8 @@ TAGE_SC_L::updateHistories(ThreadID tid, Addr pc, bool uncond,
 
     bi = static_cast<TageSclBranchInfo*>(bp_history);
     // Update the global history for all branches
-    tage.update_speculative_state(bi->id, pc, bi->br_type, taken, target);
+    threadPredictor(tid).update_speculative_state(bi->id, pc, bi->br_type,
+                                                  taken, target);
 }
 
 } // namespace branch_prediction
@@ -1,6 +1,7 @@
 #ifndef __CPU_PRED_TAGE_SC_L_HH__
 #define __CPU_PRED_TAGE_SC_L_HH__
 
+#include <memory>
 #include <vector>
 
 #include "base/types.hh"
@@ -18,7 +19,27 @@ namespace branch_prediction
 class TAGE_SC_L: public BPredUnit
 {
   private:
-    tagescl::Tage_SC_L<tagescl::CONFIG_64KB> tage;
+    typedef tagescl::Tage_SC_L<tagescl::CONFIG_64KB> Predictor;
+
+    /**
+     * With shared tables, a single predictor keeps a speculative context
+     * (histories, loop iteration counts, branches in flight and random seed)
+     * for each thread. With partitioned tables, each thread has a predictor
+     * of its own.
+     */
+    std::vector<std::unique_ptr<Predictor>> tages;
+    const bool partitionedTables;
+
+    /** The predictor of the thread, with the thread selected in it. */
+    Predictor &
+    threadPredictor(ThreadID tid)
+    {
+        if (partitionedTables) {
+            return *tages[tid];
+        }
+        tages[0]->set_active_thread(tid);
+        return *tages[0];
+    }
 
   protected:
     virtual bool predict(ThreadID tid, Addr branch_pc, bool cond_branch,
@@ -29,10 +50,24 @@ class TAGE_SC_L: public BPredUnit
         uint32_t id;
         Addr pc;
         tagescl::Branch_Type br_type;
-        TageSclBranchInfo()
-        {}
     };
 
+    /**
+     * The bp_history of every branch in flight, in a pool per thread. The
+     * ids of the branches in flight of a thread are consecutive and at most
+     * as many as the size of its pool, a power of two, so a branch owns the
+     * entry at its id modulo the size and nothing is allocated per branch.
+     */
+    std::vector<TageSclBranchInfo> branchInfoPool;
+    const uint32_t branchInfoMask;
+
+    TageSclBranchInfo *
+    allocBranchInfo(ThreadID tid, uint32_t id)
+    {
+        return &branchInfoPool[tid * (branchInfoMask + 1) +
+                               (id & branchInfoMask)];
+    }
+
   public:
 
     TAGE_SC_L(const TAGE_SC_LParams &params);
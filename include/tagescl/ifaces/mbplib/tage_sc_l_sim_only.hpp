@@ -64,10 +64,18 @@ struct MbpTageScl : mbp::Predictor {
     state = kNone;
   }
 
+  // With a CONFIG that collects statistics (see With_Statistics), they are
+  // under "statistics", nested at the slashes of their names. They include
+  // the warmup.
   mbp::json metadata_stats() const override {
-    return {
+    mbp::json stats = {
         {"name", "Adapter of Scarab's TAGE-SC-L to MBPlib"},
     };
+    for (const Statistic& statistic : impl.get_statistics()) {
+      stats["statistics"][mbp::json::json_pointer("/" + statistic.name)] =
+          statistic.value;
+    }
+    return stats;
   }
 };
 
@@ -0,0 +1,208 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPEC_TAGE_SC_L_LATENCY_PROFILE_HPP_
+#define SPEC_TAGE_SC_L_LATENCY_PROFILE_HPP_
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "utils.hpp"
+
+namespace tagescl {
+
+// Timestamps for measuring the latency of the predictor functions. On x86
+// they are read with rdtsc, fenced so that the measured code cannot move
+// across them; elsewhere they are clock_gettime() nanoseconds.
+inline uint64_t read_start_timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_lfence();
+  return __rdtsc();
+#else
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return uint64_t(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+}
+
+inline uint64_t read_end_timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int aux;
+  uint64_t timestamp = __rdtscp(&aux);
+  _mm_lfence();
+  return timestamp;
+#else
+  return read_start_timestamp();
+#endif
+}
+
+// Timestamp ticks per second. The rate of the TSC is measured once, for
+// 10ms, the first time it is needed.
+inline int64_t timestamp_ticks_per_second() {
+#if defined(__x86_64__) || defined(__i386__)
+  static const int64_t ticks_per_second = [] {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start_time = Clock::now();
+    uint64_t start = read_start_timestamp();
+    Clock::time_point end_time;
+    do {
+      end_time = Clock::now();
+    } while (end_time - start_time < std::chrono::milliseconds(10));
+    uint64_t end = read_end_timestamp();
+    double seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
+    return static_cast<int64_t>((end - start) / seconds);
+  }();
+  return ticks_per_second;
+#else
+  return 1000000000;
+#endif
+}
+
+// Histogram of latencies in timestamp ticks. Each power of two is split in
+// four buckets, so that the percentiles, reported as the largest value of the
+// bucket that reaches them, exceed the exact ones by less than 25%.
+class Latency_Histogram {
+ public:
+  void add(uint64_t ticks) {
+    buckets_[bucket_index(ticks)] += 1;
+    num_samples_ += 1;
+    total_ticks_ += ticks;
+    max_ticks_ = ticks > max_ticks_ ? ticks : max_ticks_;
+  }
+
+  int64_t num_samples() const { return num_samples_; }
+
+  // Latency not exceeded by the given fraction of the samples, or 0 if there
+  // are none.
+  uint64_t percentile(double fraction) const {
+    int64_t rank = static_cast<int64_t>(fraction * num_samples_);
+    int64_t num_seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+      num_seen += buckets_[i];
+      if (num_seen > rank) {
+        uint64_t bound = bucket_max_ticks(i);
+        return bound < max_ticks_ ? bound : max_ticks_;
+      }
+    }
+    return max_ticks_;
+  }
+
+  // Appends the number of samples, their total and maximum, some percentiles
+  // and the samples by power of two, as a Log2_Histogram, up to the largest.
+  void append_to(const std::string& name,
+                 std::vector<Statistic>* statistics) const {
+    statistics->insert(
+        statistics->end(),
+        {{name + "/samples", num_samples_},
+         {name + "/total_ticks", static_cast<int64_t>(total_ticks_)},
+         {name + "/max_ticks", static_cast<int64_t>(max_ticks_)}});
+    static const struct {
+      const char* name;
+      double fraction;
+    } percentiles[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}};
+    for (const auto& p : percentiles) {
+      statistics->push_back({name + "/" + p.name + "_ticks",
+                             static_cast<int64_t>(percentile(p.fraction))});
+    }
+    int64_t log2_buckets[65] = {};
+    int num_log2_buckets = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+      if (buckets_[i] > 0) {
+        uint64_t max_ticks = bucket_max_ticks(i);
+        int log2_bucket = max_ticks == 0 ? 0 : 64 - __builtin_clzll(max_ticks);
+        log2_buckets[log2_bucket] += buckets_[i];
+        num_log2_buckets = log2_bucket + 1;
+      }
+    }
+    for (int i = 0; i < num_log2_buckets; ++i) {
+      statistics->push_back(
+          {name + "/histogram/" + std::to_string(i), log2_buckets[i]});
+    }
+  }
+
+ private:
+  static constexpr int SUB_BUCKET_BITS = 2;
+  static constexpr int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1)
+                                     << SUB_BUCKET_BITS;
+
+  // Values below 2^SUB_BUCKET_BITS have their own bucket. Larger ones are
+  // bucketed by their SUB_BUCKET_BITS + 1 most significant bits.
+  static int bucket_index(uint64_t ticks) {
+    if (ticks < (uint64_t{1} << SUB_BUCKET_BITS)) {
+      return static_cast<int>(ticks);
+    }
+    int shift = 63 - __builtin_clzll(ticks) - SUB_BUCKET_BITS;
+    return ((shift + 1) << SUB_BUCKET_BITS) +
+           static_cast<int>((ticks >> shift) -
+                            (uint64_t{1} << SUB_BUCKET_BITS));
+  }
+
+  static uint64_t bucket_max_ticks(int index) {
+    if (index < (1 << SUB_BUCKET_BITS)) {
+      return index;
+    }
+    int shift = (index >> SUB_BUCKET_BITS) - 1;
+    uint64_t mantissa = (index & ((1 << SUB_BUCKET_BITS) - 1)) +
+                        (uint64_t{1} << SUB_BUCKET_BITS);
+    return (mantissa << shift) + ((uint64_t{1} << shift) - 1);
+  }
+
+  int64_t buckets_[NUM_BUCKETS] = {};
+  int64_t num_samples_ = 0;
+  uint64_t total_ticks_ = 0;
+  uint64_t max_ticks_ = 0;
+};
+
+// Adds the ticks elapsed between its construction and its destruction to a
+// histogram, unless the histogram is null.
+class Latency_Sample {
+ public:
+  explicit Latency_Sample(Latency_Histogram* histogram)
+      : histogram_(histogram),
+        start_(histogram ? read_start_timestamp() : 0) {}
+
+  ~Latency_Sample() {
+    if (histogram_) {
+      histogram_->add(read_end_timestamp() - start_);
+    }
+  }
+
+  Latency_Sample(const Latency_Sample&) = delete;
+  Latency_Sample& operator=(const Latency_Sample&) = delete;
+
+ private:
+  Latency_Histogram* histogram_;
+  uint64_t start_;
+};
+
+}  // namespace tagescl
+
+#endif  // SPEC_TAGE_SC_L_LATENCY_PROFILE_HPP_
@@ -22,8 +22,11 @@
 #ifndef SPEC_TAGE_SC_L_LOOP_PREDICTOR_HPP_
 #define SPEC_TAGE_SC_L_LOOP_PREDICTOR_HPP_
 
+#include <algorithm>
+#include <cassert>
 #include <vector>
 
+#include "state_file.hpp"
 #include "utils.hpp"
 
 namespace tagescl {
@@ -48,8 +51,15 @@ struct Loop_Prediction_Info {
 template <class LOOP_CONFIG>
 class Loop_Predictor {
  public:
-  Loop_Predictor(Random_Number_Generator& random_number_gen)
+  // Each of the num_threads hardware threads has its own speculative
+  // iteration counts, and they all share the entries.
+  Loop_Predictor(Random_Number_Generator& random_number_gen,
+                 int num_threads = 1)
       : table_(1 << LOOP_CONFIG::LOG_NUM_ENTRIES),
+        thread_speculative_iters_(
+            num_threads,
+            std::vector<Iteration_Counter>(1 << LOOP_CONFIG::LOG_NUM_ENTRIES)),
+        speculative_iters_(thread_speculative_iters_[0].data()),
         random_number_gen_(random_number_gen) {}
 
   void get_prediction(
@@ -73,8 +83,8 @@ class Loop_Predictor {
              (table_[index].confidence * table_[index].total_iterations > 128));
 
         prediction_info->current_iter_checkpoint =
-            table_[index].speculative_current_iter.get();
-        if (table_[index].speculative_current_iter.get() + 1 ==
+            speculative_iters_[index].get();
+        if (speculative_iters_[index].get() + 1 ==
             table_[index].total_iterations) {
           prediction_info->prediction = !table_[index].dir;
           break;
@@ -91,10 +101,10 @@ class Loop_Predictor {
     if (prediction_info.hit_bank >= 0) {
       int index = prediction_info.indices.bank[prediction_info.hit_bank];
       if (table_[index].total_iterations != 0) {
-        table_[index].speculative_current_iter.increment();
-        if (table_[index].speculative_current_iter.get() >=
+        speculative_iters_[index].increment();
+        if (speculative_iters_[index].get() >=
             table_[index].total_iterations) {
-          table_[index].speculative_current_iter.set(0);
+          speculative_iters_[index].set(0);
         }
       }
     }
@@ -103,6 +113,12 @@ class Loop_Predictor {
   void commit_state(uint64_t br_pc, bool resolve_dir,
                     const Loop_Prediction_Info<LOOP_CONFIG>& prediction_info,
                     bool finally_mispredicted, bool tage_prediction) {
+    if (LOOP_CONFIG::COLLECT_STATISTICS) {
+      statistics_.hits += prediction_info.hit_bank >= 0;
+      statistics_.valid_predictions += prediction_info.valid;
+      statistics_.valid_mispredictions +=
+          prediction_info.valid && prediction_info.prediction != resolve_dir;
+    }
     if (prediction_info.hit_bank >= 0) {
       int index = prediction_info.indices.bank[prediction_info.hit_bank];
       if (table_[index].tag != prediction_info.tag) {
@@ -117,7 +133,7 @@ class Loop_Predictor {
           table_[index].confidence = 0;
           table_[index].age = 0;
           table_[index].current_iter.set(0);
-          table_[index].speculative_current_iter.set(0);
+          reset_speculative_iters(index);
           return;
         } else if ((prediction_info.prediction != tage_prediction) ||
                    ((random_number_gen_() & 7) == 0)) {
@@ -148,14 +164,14 @@ class Loop_Predictor {
             table_[index].total_iterations = 0;
             table_[index].age = 0;
             table_[index].current_iter.set(0);
-            table_[index].speculative_current_iter.set(0);
+            reset_speculative_iters(index);
           }
         } else {
           if (table_[index].total_iterations == 0) {
             // first complete nest;
             table_[index].confidence = 0;
             table_[index].total_iterations = table_[index].current_iter.get();
-            table_[index].speculative_current_iter.set(0);
+            reset_speculative_iters(index);
           } else {
             // not the same number of iterations as last time: free
             // the entry
@@ -167,7 +183,7 @@ class Loop_Predictor {
       }
 
       if (finally_mispredicted) {
-        table_[index].speculative_current_iter = table_[index].current_iter;
+        speculative_iters_[index] = table_[index].current_iter;
       }
     } else if (finally_mispredicted) {
       int random_bank = random_number_gen_() & 3;
@@ -183,7 +199,10 @@ class Loop_Predictor {
           table_[index].age = 7;
           table_[index].confidence = 0;
           table_[index].current_iter.set(0);
-          table_[index].speculative_current_iter.set(0);
+          reset_speculative_iters(index);
+          if (LOOP_CONFIG::COLLECT_STATISTICS) {
+            statistics_.allocations += 1;
+          }
         } else {
           table_[index].age -= 1;
         }
@@ -207,8 +226,7 @@ class Loop_Predictor {
         // The entry must have been replaced by anoher entry.
         return;
       }
-      table_[index].speculative_current_iter =
-          prediction_info.current_iter_checkpoint;
+      speculative_iters_[index] = prediction_info.current_iter_checkpoint;
     }
   }
 
@@ -217,17 +235,64 @@ class Loop_Predictor {
     prediction_info->hit_bank = -1;
   }
 
+  // Saves and loads the entries. There should be no branches in flight. The
+  // speculative iteration counts saved are those of the active thread, and
+  // the loaded ones replace those of every thread.
+  void save_state(State_Writer* writer) const {
+    writer->write(table_.data(), table_.size());
+    writer->write(speculative_iters_, table_.size());
+  }
+  void load_state(State_Reader* reader) {
+    reader->read(table_.data(), table_.size());
+    reader->read(speculative_iters_, table_.size());
+    for (auto& speculative_iters : thread_speculative_iters_) {
+      std::copy(speculative_iters_, speculative_iters_ + table_.size(),
+                speculative_iters.begin());
+    }
+  }
+
+  // Makes the speculative iteration counts of thread_id the ones that the
+  // rest of the functions read and update.
+  void set_active_thread(int thread_id) {
+    assert(0 <= thread_id &&
+           thread_id < static_cast<int>(thread_speculative_iters_.size()));
+    speculative_iters_ = thread_speculative_iters_[thread_id].data();
+  }
+
+  static void fingerprint_config(Config_Fingerprint* fingerprint) {
+    fingerprint->add(LOOP_CONFIG::LOG_NUM_ENTRIES);
+    fingerprint->add(LOOP_CONFIG::ITERATION_COUNTER_WIDTH);
+    fingerprint->add(LOOP_CONFIG::TAG_BITS);
+    fingerprint->add(LOOP_CONFIG::CONFIDENCE_THRESHOLD);
+  }
+
+  // Appends the counters collected since the construction or the last
+  // reset_statistics(), under "loop/". Does nothing unless
+  // LOOP_CONFIG::COLLECT_STATISTICS.
+  void append_statistics(std::vector<Statistic>* statistics) const {
+    if (!LOOP_CONFIG::COLLECT_STATISTICS) {
+      return;
+    }
+    statistics->insert(
+        statistics->end(),
+        {{"loop/hits", statistics_.hits},
+         {"loop/valid_predictions", statistics_.valid_predictions},
+         {"loop/valid_mispredictions", statistics_.valid_mispredictions},
+         {"loop/allocations", statistics_.allocations}});
+  }
+  void reset_statistics() { statistics_ = {}; }
+
  private:
+  using Iteration_Counter =
+      Saturating_Counter<LOOP_CONFIG::ITERATION_COUNTER_WIDTH, false>;
+
   struct LoopPredictorEntry {
-    int16_t total_iterations = 0;  // 10 bits
-    int16_t tag = 0;               // 10 bits
-    int8_t confidence = 0;         // 4 bits
-    int8_t age = 0;                // 4 bits
-    bool dir = 0;                  // 1 bit
-    Saturating_Counter<LOOP_CONFIG::ITERATION_COUNTER_WIDTH, false>
-        speculative_current_iter;  // 10 bits
-    Saturating_Counter<LOOP_CONFIG::ITERATION_COUNTER_WIDTH, false>
-        current_iter;  // 10 bits
+    int16_t total_iterations = 0;    // 10 bits
+    int16_t tag = 0;                 // 10 bits
+    int8_t confidence = 0;           // 4 bits
+    int8_t age = 0;                  // 4 bits
+    bool dir = 0;                    // 1 bit
+    Iteration_Counter current_iter;  // 10 bits
 
     LoopPredictorEntry() : current_iter(0) {}
   };
@@ -235,9 +300,32 @@ class Loop_Predictor {
   Loop_Predictor_Indices get_indices(uint64_t br_pc) const;
   int get_tag(uint64_t br_pc) const;
 
+  // The entry at index was freed or replaced, so no thread is in the middle
+  // of its loop anymore.
+  void reset_speculative_iters(int index) {
+    for (auto& speculative_iters : thread_speculative_iters_) {
+      speculative_iters[index].set(0);
+    }
+  }
+
   std::vector<LoopPredictorEntry> table_;
+  // The speculative iteration counts of each thread, by entry (10 bits each).
+  std::vector<std::vector<Iteration_Counter>> thread_speculative_iters_;
+  // The speculative iteration counts of the active thread.
+  Iteration_Counter* speculative_iters_;
 
   Random_Number_Generator& random_number_gen_;
+
+  // Counters of committed branches, only updated if
+  // LOOP_CONFIG::COLLECT_STATISTICS. Whether a valid prediction overrode TAGE
+  // is decided, and counted, by Tage_SC_L.
+  struct Statistics {
+    int64_t hits = 0;
+    int64_t valid_predictions = 0;
+    int64_t valid_mispredictions = 0;
+    int64_t allocations = 0;
+  };
+  Statistics statistics_;
 };
 
 template <class LOOP_CONFIG>
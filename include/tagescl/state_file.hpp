@@ -0,0 +1,271 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef SPEC_TAGE_SC_L_STATE_FILE_HPP_
+#define SPEC_TAGE_SC_L_STATE_FILE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace tagescl {
+
+/* Files with the committed state of a predictor, used to warm up once and
+ * start many simulations from the same state. A file is a State_File_Header
+ * followed by the sections written by the predictor components, in order.
+ * Every section is an array of trivially copyable values preceded by a
+ * State_File_Section_Header. Headers and arrays start at multiples of
+ * state_file_alignment bytes, so that the tables of a mapped file can be
+ * read in place. Values are stored in the byte order of the writer. */
+constexpr char state_file_magic[8] = {'T', 'A', 'G', 'E', 'S', 'C', 'L', '\0'};
+constexpr uint32_t state_file_version = 2;
+constexpr uint32_t state_file_byte_order_mark = 0x01020304;
+constexpr int state_file_alignment = 64;
+
+struct alignas(state_file_alignment) State_File_Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+  // Config_Fingerprint of the configuration of the predictor.
+  uint64_t config_fingerprint;
+  uint64_t num_sections;
+  uint64_t file_size;
+};
+
+struct alignas(state_file_alignment) State_File_Section_Header {
+  uint64_t element_size;
+  uint64_t num_elements;
+};
+
+// FNV-1a hash of the configuration parameters that determine the layout and
+// the meaning of the state of a predictor.
+class Config_Fingerprint {
+ public:
+  void add(int64_t value) {
+    for (int i = 0; i < 8; ++i) {
+      value_ ^= (static_cast<uint64_t>(value) >> (8 * i)) & 0xFF;
+      value_ *= 0x100000001B3ull;
+    }
+  }
+
+  // Adds the length and the values of Array::arr.
+  template <class Array>
+  void add_array() {
+    constexpr int size = sizeof(Array::arr) / sizeof(Array::arr[0]);
+    add(size);
+    for (int i = 0; i < size; ++i) {
+      add(Array::arr[i]);
+    }
+  }
+
+  uint64_t value() const { return value_; }
+
+ private:
+  uint64_t value_ = 0xCBF29CE484222325ull;
+};
+
+// Builds a state file in memory and writes it out with save().
+class State_Writer {
+ public:
+  template <class T>
+  void write(const T* values, std::size_t num_values) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "State sections must be trivially copyable");
+    State_File_Section_Header header = {};
+    header.element_size = sizeof(T);
+    header.num_elements = num_values;
+    append(&header, sizeof(header));
+    append(values, sizeof(T) * num_values);
+    num_sections_ += 1;
+  }
+
+  template <class T>
+  void write(const T& value) {
+    write(&value, 1);
+  }
+
+  // Returns false if the file could not be written.
+  bool save(const std::string& path, uint64_t config_fingerprint) const {
+    State_File_Header header = {};
+    std::memcpy(header.magic, state_file_magic, sizeof(header.magic));
+    header.version = state_file_version;
+    header.byte_order_mark = state_file_byte_order_mark;
+    header.config_fingerprint = config_fingerprint;
+    header.num_sections = num_sections_;
+    header.file_size = sizeof(header) + sections_.size();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+      return false;
+    }
+    bool written =
+        std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+        std::fwrite(sections_.data(), 1, sections_.size(), file) ==
+            sections_.size();
+    return std::fclose(file) == 0 && written;
+  }
+
+ private:
+  // Appends num_bytes bytes and pads the sections to the alignment.
+  void append(const void* data, std::size_t num_bytes) {
+    const char* bytes = static_cast<const char*>(data);
+    sections_.insert(sections_.end(), bytes, bytes + num_bytes);
+    std::size_t padding = -sections_.size() % state_file_alignment;
+    sections_.insert(sections_.end(), padding, '\0');
+  }
+
+  std::vector<char> sections_;
+  uint64_t num_sections_ = 0;
+};
+
+/* Maps a state file and reads its sections in order. The file is rejected if
+ * it is not a state file of this version, byte order and configuration, or
+ * if its sections do not fit in it. A read that does not match the type and
+ * size of the next section fails, and so do all the following ones. */
+class State_Reader {
+ public:
+  State_Reader(const std::string& path, uint64_t config_fingerprint) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 &&
+        file_stat.st_size >=
+            static_cast<off_t>(sizeof(State_File_Header))) {
+      void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                           fd, 0);
+      if (mapping != MAP_FAILED) {
+        data_ = static_cast<const char*>(mapping);
+        size_ = file_stat.st_size;
+      }
+    }
+    close(fd);
+    ok_ = data_ && validate(config_fingerprint);
+  }
+
+  ~State_Reader() {
+    if (data_) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  State_Reader(const State_Reader&) = delete;
+  State_Reader& operator=(const State_Reader&) = delete;
+
+  // Returns the values of the next section in place, or nullptr if it does
+  // not hold num_values values of type T.
+  template <class T>
+  const T* section(std::size_t num_values) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "State sections must be trivially copyable");
+    if (!ok_ || num_sections_left_ == 0) {
+      ok_ = false;
+      return nullptr;
+    }
+    State_File_Section_Header header;
+    std::memcpy(&header, data_ + offset_, sizeof(header));
+    if (header.element_size != sizeof(T) ||
+        header.num_elements != num_values) {
+      ok_ = false;
+      return nullptr;
+    }
+    const T* values =
+        reinterpret_cast<const T*>(data_ + offset_ + sizeof(header));
+    offset_ += section_size(header);
+    num_sections_left_ -= 1;
+    return values;
+  }
+
+  template <class T>
+  void read(T* values, std::size_t num_values) {
+    const T* section_values = section<T>(num_values);
+    if (section_values) {
+      std::memcpy(static_cast<void*>(values), section_values,
+                  sizeof(T) * num_values);
+    }
+  }
+
+  template <class T>
+  void read(T* value) {
+    read(value, 1);
+  }
+
+  // True if the file was accepted and every read so far succeeded.
+  bool ok() const { return ok_; }
+
+  // True if ok() and all the sections have been read.
+  bool done() const { return ok_ && num_sections_left_ == 0; }
+
+ private:
+  static uint64_t section_size(const State_File_Section_Header& header) {
+    uint64_t data_size = header.element_size * header.num_elements;
+    return sizeof(header) + (data_size + state_file_alignment - 1) /
+                                state_file_alignment * state_file_alignment;
+  }
+
+  bool validate(uint64_t config_fingerprint) {
+    State_File_Header header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, state_file_magic, sizeof(header.magic)) ||
+        header.version != state_file_version ||
+        header.byte_order_mark != state_file_byte_order_mark ||
+        header.config_fingerprint != config_fingerprint ||
+        header.file_size != size_) {
+      return false;
+    }
+    uint64_t offset = sizeof(header);
+    for (uint64_t i = 0; i < header.num_sections; ++i) {
+      State_File_Section_Header section_header;
+      if (size_ - offset < sizeof(section_header)) {
+        return false;
+      }
+      std::memcpy(&section_header, data_ + offset, sizeof(section_header));
+      if (section_header.element_size == 0 ||
+          section_header.num_elements > size_ / section_header.element_size ||
+          size_ - offset < section_size(section_header)) {
+        return false;
+      }
+      offset += section_size(section_header);
+    }
+    offset_ = sizeof(header);
+    num_sections_left_ = header.num_sections;
+    return true;
+  }
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+  std::size_t offset_ = 0;
+  uint64_t num_sections_left_ = 0;
+  bool ok_ = false;
+};
+
+}  // namespace tagescl
+
+#endif  // SPEC_TAGE_SC_L_STATE_FILE_HPP_
@@ -22,7 +22,15 @@
 #ifndef SPEC_TAGE_SC_L_STATISTICAL_CORRECTOR_HPP_
 #define SPEC_TAGE_SC_L_STATISTICAL_CORRECTOR_HPP_
 
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
 #include "loop_predictor.hpp"
+#include "state_file.hpp"
 #include "tage.hpp"
 #include "utils.hpp"
 
@@ -53,6 +61,11 @@ class Threshold_Table {
     return (br_pc ^ (br_pc >> 2)) & (table_size - 1);
   }
 
+  void save_state(State_Writer* writer) const {
+    writer->write(table_, table_size);
+  }
+  void load_state(State_Reader* reader) { reader->read(table_, table_size); }
+
  private:
   static constexpr int table_size = 1 << log_table_size;
   Counter_Type table_[table_size];
@@ -66,6 +79,11 @@ class Local_History_Table {
   int64_t get_history(uint64_t br_pc) const { return table_[get_index(br_pc)]; }
   int64_t& get_history(uint64_t br_pc) { return table_[get_index(br_pc)]; }
 
+  void save_state(State_Writer* writer) const {
+    writer->write(table_, table_size);
+  }
+  void load_state(State_Reader* reader) { reader->read(table_, table_size); }
+
  private:
   static constexpr int table_size = 1 << log_table_size;
 
@@ -77,16 +95,18 @@ class Local_History_Table {
   int64_t table_[table_size];
 };
 
-// A GEHL Table. Used by Statistical Corrector.
+// A GEHL Table. Used by Statistical Corrector. The counters live in the
+// num_counters entries starting at the counters given to the constructor, so
+// that the owner can keep the tables of several GEHLs in a single allocation.
 template <int counter_width, class Histories, int log_table_size>
 class Gehl {
  public:
   using Counter_Type = Saturating_Counter<counter_width, true>;
 
-  Gehl() : tables_() {
+  explicit Gehl(Counter_Type* counters) : counters_(counters) {
     for (int i = 0; i < num_histories; ++i) {
       for (int j = 0; j < ((1 << log_table_size) - 1); ++j) {
-        tables_[i][j].set((j & 1) ? 0 : -1);
+        table(i)[j].set((j & 1) ? 0 : -1);
       }
     }
   }
@@ -95,7 +115,7 @@ class Gehl {
     int sum = 0;
     for (int i = 0; i < num_histories; i++) {
       int index = get_index(br_pc, history, i);
-      sum += (2 * tables_[i][index].get() + 1);
+      sum += (2 * table(i)[index].get() + 1);
     }
     return sum;
   }
@@ -103,29 +123,261 @@ class Gehl {
   void update(uint64_t br_pc, int64_t history, bool resolve_dir) {
     for (int i = 0; i < num_histories; i++) {
       int index = get_index(br_pc, history, i);
-      tables_[i][index].update(resolve_dir);
+      table(i)[index].update(resolve_dir);
     }
   }
 
- private:
+  void prefetch(uint64_t br_pc, int64_t history) const {
+    for (int i = 0; i < num_histories; i++) {
+      __builtin_prefetch(&table(i)[get_index(br_pc, history, i)]);
+    }
+  }
+
+  // Adds the tables of this GEHL to kernel as lanes of the given component.
+  // The sums computed by the kernel are the ones of get_prediction_sum().
+  template <class Kernel>
+  void add_kernel_lanes(Kernel* kernel, int component) const {
+    for (int i = 0; i < num_histories; i++) {
+      kernel->add_lane(component, table(i), Histories::arr[i],
+                       index_shifts(i), index_mask(i));
+    }
+  }
+
+  // The tables are loaded in place, so the lanes added to a kernel remain
+  // valid.
+  void save_state(State_Writer* writer) const {
+    for (int i = 0; i < num_histories; ++i) {
+      writer->write(table(i), 1 << log_table_size);
+    }
+  }
+  void load_state(State_Reader* reader) {
+    for (int i = 0; i < num_histories; ++i) {
+      reader->read(table(i), 1 << log_table_size);
+    }
+  }
+
+  // The counters that follow the ones of this GEHL.
+  Counter_Type* end() const { return counters_ + num_counters; }
+
   static constexpr int num_histories =
       sizeof(Histories::arr) / sizeof(Histories::arr[0]);
+  // Every table is followed by 3 bytes of padding, so that the 32-bit reads
+  // of a Gehl_Sum_Kernel stay inside the tables.
+  static constexpr int padded_table_size =
+      (1 << log_table_size) +
+      (3 + sizeof(Counter_Type) - 1) / sizeof(Counter_Type);
+  static constexpr int num_counters = num_histories * padded_table_size;
+
+ private:
+  static constexpr int num_index_shifts = 5;
+
+  struct Index_Shifts {
+    int arr[num_index_shifts];
+  };
+
+  static constexpr Index_Shifts index_shifts(int history_id) {
+    return {{8 - history_id, 16 - 2 * history_id, 24 - 3 * history_id,
+             32 - 3 * history_id, 40 - 4 * history_id}};
+  }
+
+  static constexpr int index_mask(int history_id) {
+    return (1 << (log_table_size - (history_id >= (num_histories - 2)))) - 1;
+  }
 
   int get_index(uint64_t br_pc, int64_t history, int history_id) const {
     int64_t masked_history =
         history & ((int64_t(1) << Histories::arr[history_id]) - 1);
     int64_t index = br_pc ^ masked_history;
-    index ^= masked_history >> (8 - history_id);
-    index ^= masked_history >> (16 - 2 * history_id);
-    index ^= masked_history >> (24 - 3 * history_id);
-    index ^= masked_history >> (32 - 3 * history_id);
-    index ^= masked_history >> (40 - 4 * history_id);
-    index &=
-        ((1 << (log_table_size - (history_id >= (num_histories - 2)))) - 1);
+    for (int shift : index_shifts(history_id).arr) {
+      index ^= masked_history >> shift;
+    }
+    index &= index_mask(history_id);
     return static_cast<int>(index);
   }
 
-  Counter_Type tables_[num_histories][1 << log_table_size];
+  Counter_Type* table(int history_id) const {
+    return counters_ + history_id * padded_table_size;
+  }
+
+  Counter_Type* counters_;
+};
+
+/* Computes the sums of the GEHL tables of several SC components at once.
+ * Every table is a lane: the indices of all tables are computed in SIMD
+ * lanes and their counters are gathered as 32-bit words at their offsets from
+ * the start of the counters, which hold every table. Each table must be
+ * followed by 3 bytes of padding (see Gehl::padded_table_size). The kernel
+ * keeps a pointer to the counters, so their owner cannot be copied or moved
+ * after adding the lanes. */
+template <class Counter_Type, int max_lanes, int num_components>
+class Gehl_Sum_Kernel {
+ public:
+  explicit Gehl_Sum_Kernel(const Counter_Type* counters)
+      : counters_(counters),
+        num_lanes_(0),
+        table_offsets_(),
+        history_masks_(),
+        index_masks_(),
+        index_shifts_(),
+        components_() {}
+
+  template <class Index_Shifts>
+  void add_lane(int component, const Counter_Type* table, int history_length,
+                const Index_Shifts& index_shifts, int index_mask) {
+    assert(num_lanes_ < max_lanes);
+    assert(0 <= component && component < num_components);
+    assert(table >= counters_);
+    int lane = num_lanes_++;
+    table_offsets_[lane] = static_cast<int32_t>(table - counters_);
+    history_masks_[lane] = (int64_t(1) << history_length) - 1;
+    index_masks_[lane] = index_mask;
+    for (int i = 0; i < num_index_shifts_; ++i) {
+      index_shifts_[i][lane] = index_shifts.arr[i];
+    }
+    components_[lane] = component;
+  }
+
+  // Sets sums[c] to the sum of (2 * counter + 1) over the tables of component
+  // c, indexed with br_pcs[c] and histories[c].
+  void compute_sums(const uint64_t* br_pcs, const int64_t* histories,
+                    int* sums) const;
+
+ private:
+  static_assert(sizeof(Counter_Type) ==
+                        sizeof(typename Counter_Type::Int_Type) &&
+                    sizeof(Counter_Type) <= 4,
+                "Counters are read directly from memory as 32-bit words");
+#if defined(__AVX512F__)
+  static constexpr int simd_lanes_ = 8;
+#elif defined(__AVX2__)
+  static constexpr int simd_lanes_ = 4;
+#else
+  static constexpr int simd_lanes_ = 1;
+#endif
+  static constexpr int padded_max_lanes_ =
+      (max_lanes + simd_lanes_ - 1) / simd_lanes_ * simd_lanes_;
+  static constexpr int num_index_shifts_ = 5;
+
+  const Counter_Type* counters_;
+  int num_lanes_;
+  // Padding lanes read the first counter and are never added.
+  alignas(64) int32_t table_offsets_[padded_max_lanes_];
+  alignas(64) int64_t history_masks_[padded_max_lanes_];
+  alignas(64) int64_t index_masks_[padded_max_lanes_];
+  alignas(64) int64_t index_shifts_[num_index_shifts_][padded_max_lanes_];
+  alignas(64) int32_t components_[padded_max_lanes_];
+};
+
+// GCC 12 warns about the undefined pass-through operands of the AVX-512
+// intrinsics themselves.
+#if defined(__AVX512F__) && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+template <class Counter_Type, int max_lanes, int num_components>
+void Gehl_Sum_Kernel<Counter_Type, max_lanes, num_components>::compute_sums(
+    const uint64_t* br_pcs, const int64_t* histories, int* sums) const {
+  alignas(64) int32_t lane_values[padded_max_lanes_];
+#if defined(__AVX512F__) || defined(__AVX2__)
+  // Counters are read as 32-bit words and sign-extended from their width.
+  constexpr int counter_shift = 32 - 8 * sizeof(Counter_Type);
+  const int* counters = reinterpret_cast<const int*>(counters_);
+  const long long* pcs = reinterpret_cast<const long long*>(br_pcs);
+  const long long* hists = reinterpret_cast<const long long*>(histories);
+#endif
+  for (int i = 0; i < num_lanes_; i += simd_lanes_) {
+#if defined(__AVX512F__)
+    __m256i component = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(components_ + i));
+    __m512i masked_history =
+        _mm512_and_si512(_mm512_i32gather_epi64(component, hists, 8),
+                         _mm512_load_si512(history_masks_ + i));
+    __m512i index =
+        _mm512_xor_si512(_mm512_i32gather_epi64(component, pcs, 8),
+                         masked_history);
+    for (int j = 0; j < num_index_shifts_; ++j) {
+      index = _mm512_xor_si512(
+          index, _mm512_srlv_epi64(masked_history,
+                                   _mm512_load_si512(index_shifts_[j] + i)));
+    }
+    index = _mm512_and_si512(index, _mm512_load_si512(index_masks_ + i));
+    // The masked indices fit in 32 bits.
+    __m256i offset = _mm256_add_epi32(
+        _mm256_load_si256(
+            reinterpret_cast<const __m256i*>(table_offsets_ + i)),
+        _mm512_cvtepi64_epi32(index));
+    __m256i counter =
+        _mm256_i32gather_epi32(counters, offset, sizeof(Counter_Type));
+    counter = _mm256_srai_epi32(_mm256_slli_epi32(counter, counter_shift),
+                                counter_shift);
+    _mm256_store_si256(
+        reinterpret_cast<__m256i*>(lane_values + i),
+        _mm256_add_epi32(_mm256_add_epi32(counter, counter),
+                         _mm256_set1_epi32(1)));
+#elif defined(__AVX2__)
+    __m128i component = _mm_load_si128(
+        reinterpret_cast<const __m128i*>(components_ + i));
+    __m256i masked_history = _mm256_and_si256(
+        _mm256_i32gather_epi64(hists, component, 8),
+        _mm256_load_si256(
+            reinterpret_cast<const __m256i*>(history_masks_ + i)));
+    __m256i index = _mm256_xor_si256(
+        _mm256_i32gather_epi64(pcs, component, 8), masked_history);
+    for (int j = 0; j < num_index_shifts_; ++j) {
+      index = _mm256_xor_si256(
+          index, _mm256_srlv_epi64(
+                     masked_history,
+                     _mm256_load_si256(reinterpret_cast<const __m256i*>(
+                         index_shifts_[j] + i))));
+    }
+    index = _mm256_and_si256(
+        index,
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(index_masks_ + i)));
+    // The masked indices fit in 32 bits, so only the low halves are kept.
+    __m128i offset = _mm_add_epi32(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(table_offsets_ + i)),
+        _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+            index, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6))));
+    __m128i counter =
+        _mm_i32gather_epi32(counters, offset, sizeof(Counter_Type));
+    counter = _mm_srai_epi32(_mm_slli_epi32(counter, counter_shift),
+                             counter_shift);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lane_values + i),
+                    _mm_add_epi32(_mm_add_epi32(counter, counter),
+                                  _mm_set1_epi32(1)));
+#else
+    int64_t masked_history = histories[components_[i]] & history_masks_[i];
+    int64_t index = br_pcs[components_[i]] ^ masked_history;
+    for (int j = 0; j < num_index_shifts_; ++j) {
+      index ^= masked_history >> index_shifts_[j][i];
+    }
+    index &= index_masks_[i];
+    lane_values[i] = 2 * counters_[table_offsets_[i] + index].get() + 1;
+#endif
+  }
+
+  for (int c = 0; c < num_components; ++c) {
+    sums[c] = 0;
+  }
+  for (int i = 0; i < num_lanes_; ++i) {
+    sums[components_[i]] += lane_values[i];
+  }
+}
+#if defined(__AVX512F__) && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// The components of the SC, in the order of SC_Prediction_Info::component_sums.
+enum SC_Component {
+  SC_BIASES,
+  SC_GLOBAL_HISTORY_GEHL,
+  SC_PATH_GEHL,
+  SC_FIRST_LOCAL_GEHL,
+  SC_SECOND_LOCAL_GEHL,
+  SC_THIRD_LOCAL_GEHL,
+  SC_FIRST_IMLI_GEHL,
+  SC_SECOND_IMLI_GEHL,
+  SC_NUM_COMPONENTS
 };
 
 struct SC_Histories_Snapshot {
@@ -143,13 +395,67 @@ struct SC_Prediction_Info {
   int thresholds_sum;
   bool prediction;
 
+  // Sum of (2 * counter + 1) over the tables of each component, before the
+  // variable thresholds double it. Kept so that commit_state() does not have
+  // to read the counters again.
+  int component_sums[SC_NUM_COMPONENTS];
+
   SC_Histories_Snapshot history_snapshot;
 };
 
+// The speculative histories of a thread, updated by update_speculative_state()
+// and repaired after a misprediction from the SC_Histories_Snapshot of the
+// branch.
+template <class CONFIG>
+class SC_Histories {
+ public:
+  SC_Histories() : imli_counter_(0), imli_table_() {}
+
+  // The local history of the current IMLI iteration.
+  int64_t imli_history() const { return imli_table_[imli_counter_.get()]; }
+  int64_t& imli_history() { return imli_table_[imli_counter_.get()]; }
+
+  // Saves and loads the histories. There should be no branches in flight.
+  void save_state(State_Writer* writer) const {
+    writer->write(global_history_);
+    writer->write(path_);
+    first_local_history_table_.save_state(writer);
+    second_local_history_table_.save_state(writer);
+    third_local_history_table_.save_state(writer);
+    writer->write(imli_counter_);
+    writer->write(imli_table_, CONFIG::SC::IMLI_TABLE_SIZE);
+  }
+  void load_state(State_Reader* reader) {
+    reader->read(&global_history_);
+    reader->read(&path_);
+    first_local_history_table_.load_state(reader);
+    second_local_history_table_.load_state(reader);
+    third_local_history_table_.load_state(reader);
+    reader->read(&imli_counter_);
+    reader->read(imli_table_, CONFIG::SC::IMLI_TABLE_SIZE);
+  }
+
+  int64_t global_history_ = 0;
+  int64_t path_ = 0;
+  Local_History_Table<CONFIG::SC::FIRST_LOCAL_HISTORY_LOG_TABLE_SIZE,
+                      CONFIG::SC::FIRST_LOCAL_HISTORY_SHIFT>
+      first_local_history_table_;
+  Local_History_Table<CONFIG::SC::SECOND_LOCAL_HISTORY_LOG_TABLE_SIZE,
+                      CONFIG::SC::SECOND_LOCAL_HISTORY_SHIFT>
+      second_local_history_table_;
+  Local_History_Table<CONFIG::SC::THIRD_LOCAL_HISTORY_LOG_TABLE_SIZE,
+                      CONFIG::SC::THIRD_LOCAL_HISTORY_SHIFT>
+      third_local_history_table_;
+  Saturating_Counter<CONFIG::SC::IMLI_COUNTER_WIDTH, false> imli_counter_;
+  int64_t imli_table_[CONFIG::SC::IMLI_TABLE_SIZE];
+};
+
 template <class CONFIG>
 class Statistical_Corrector {
  public:
-  Statistical_Corrector();
+  // Each of the num_threads hardware threads has its own histories, and they
+  // all share the tables.
+  explicit Statistical_Corrector(int num_threads = 1);
 
   void get_prediction(
       uint64_t br_pc,
@@ -168,29 +474,80 @@ class Statistical_Corrector {
 
   void commit_state_at_retire() {}
 
+  // Saves and loads the tables and the histories. There should be no branches
+  // in flight. The histories saved are those of the active thread, and the
+  // loaded ones replace those of every thread.
+  void save_state(State_Writer* writer) const;
+  void load_state(State_Reader* reader);
+
+  // Makes the histories of thread_id the ones that the rest of the functions
+  // read and update.
+  void set_active_thread(int thread_id) {
+    assert(0 <= thread_id &&
+           thread_id < static_cast<int>(thread_histories_.size()));
+    histories_ = &thread_histories_[thread_id];
+  }
+
+  // Adds the parameters of CONFIG::SC that affect the saved state.
+  static void fingerprint_config(Config_Fingerprint* fingerprint);
+
+  // Appends the counters collected since the construction or the last
+  // reset_statistics(), under "sc/". Does nothing unless
+  // CONFIG::SC::COLLECT_STATISTICS.
+  void append_statistics(std::vector<Statistic>* statistics) const;
+  void reset_statistics() { statistics_ = {}; }
+
+  // Prefetches the GEHL entries that get_prediction() would read for br_pc
+  // with the current speculative histories. The bias and threshold tables
+  // are small enough to stay in the cache.
+  void prefetch(uint64_t br_pc) const {
+    // The last bit of the global history GEHL index is the TAGE prediction,
+    // which only selects the neighbouring entry.
+    global_history_gehl_.prefetch(br_pc << 1, histories_->global_history_);
+    path_gehl_.prefetch(br_pc, histories_->path_);
+    if (CONFIG::SC::USE_LOCAL_HISTORY) {
+      first_local_gehl_.prefetch(
+          br_pc, histories_->first_local_history_table_.get_history(br_pc));
+      if (CONFIG::SC::USE_SECOND_LOCAL_HISTORY) {
+        second_local_gehl_.prefetch(
+            br_pc, histories_->second_local_history_table_.get_history(br_pc));
+      }
+      if (CONFIG::SC::USE_THIRD_LOCAL_HISTORY) {
+        third_local_gehl_.prefetch(
+            br_pc, histories_->third_local_history_table_.get_history(br_pc));
+      }
+    }
+    if (CONFIG::SC::USE_IMLI) {
+      second_imli_gehl_.prefetch(br_pc, histories_->imli_history());
+      first_imli_gehl_.prefetch(br_pc, histories_->imli_counter_.get());
+    }
+  }
+
   void global_recover_speculative_state(
       const SC_Prediction_Info& prediction_info) {
-    global_history_ = prediction_info.history_snapshot.global_history;
-    path_ = prediction_info.history_snapshot.path;
+    histories_->global_history_ =
+        prediction_info.history_snapshot.global_history;
+    histories_->path_ = prediction_info.history_snapshot.path;
   }
 
   void local_recover_speculative_state(
       uint64_t br_pc, const SC_Prediction_Info& prediction_info) {
     if (CONFIG::SC::USE_LOCAL_HISTORY) {
-      first_local_history_table_.get_history(br_pc) =
+      histories_->first_local_history_table_.get_history(br_pc) =
           prediction_info.history_snapshot.first_local_history;
       if (CONFIG::SC::USE_SECOND_LOCAL_HISTORY) {
-        second_local_history_table_.get_history(br_pc) =
+        histories_->second_local_history_table_.get_history(br_pc) =
             prediction_info.history_snapshot.second_local_history;
       }
       if (CONFIG::SC::USE_THIRD_LOCAL_HISTORY) {
-        third_local_history_table_.get_history(br_pc) =
+        histories_->third_local_history_table_.get_history(br_pc) =
             prediction_info.history_snapshot.third_local_history;
       }
     }
     if (CONFIG::SC::USE_IMLI) {
-      imli_counter_.set(prediction_info.history_snapshot.imli_counter);
-      imli_table_[imli_counter_.get()] =
+      histories_->imli_counter_.set(
+          prediction_info.history_snapshot.imli_counter);
+      histories_->imli_history() =
           prediction_info.history_snapshot.imli_local_history;
     }
   }
@@ -208,14 +565,13 @@ class Statistical_Corrector {
 
   int get_threshold_table_index(uint64_t br_pc);
 
-  template <int PRECISION, class Gehl_Histories, int gehl_log_table_size,
-            int threshold_width, int log_threshold_table_size>
+  template <int threshold_width, int log_threshold_table_size>
   int get_gehl_prediction_sum(
-      const Gehl<PRECISION, Gehl_Histories, gehl_log_table_size>& gehl,
+      int gehl_sum,
       const Threshold_Table<threshold_width, log_threshold_table_size>&
           threshold_table,
-      uint64_t br_pc, int64_t history) const {
-    int prediction = gehl.get_prediction_sum(br_pc, history);
+      uint64_t br_pc) const {
+    int prediction = gehl_sum;
     if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
       if (threshold_table.get_entry(br_pc).get() >= 0) {
         prediction *= 2;
@@ -231,8 +587,7 @@ class Statistical_Corrector {
       Threshold_Table<threshold_width, log_threshold_table_size>*
           threshold_table,
       uint64_t br_pc, int64_t history, bool resolve_dir,
-      int total_prediction_sum) {
-    int gehl_sum = gehl->get_prediction_sum(br_pc, history);
+      int total_prediction_sum, int gehl_sum) {
     gehl->update(br_pc, history, resolve_dir);
 
     if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
@@ -265,19 +620,9 @@ class Statistical_Corrector {
       const Tage_Prediction_Info<typename CONFIG::TAGE>& tage_prediction_info,
       bool tage_or_loop_prediction);
 
-  int64_t global_history_ = 0;
-  int64_t path_ = 0;
-  Local_History_Table<CONFIG::SC::FIRST_LOCAL_HISTORY_LOG_TABLE_SIZE,
-                      CONFIG::SC::FIRST_LOCAL_HISTORY_SHIFT>
-      first_local_history_table_;
-  Local_History_Table<CONFIG::SC::SECOND_LOCAL_HISTORY_LOG_TABLE_SIZE,
-                      CONFIG::SC::SECOND_LOCAL_HISTORY_SHIFT>
-      second_local_history_table_;
-  Local_History_Table<CONFIG::SC::THIRD_LOCAL_HISTORY_LOG_TABLE_SIZE,
-                      CONFIG::SC::THIRD_LOCAL_HISTORY_SHIFT>
-      third_local_history_table_;
-  Saturating_Counter<CONFIG::SC::IMLI_COUNTER_WIDTH, false> imli_counter_;
-  int64_t imli_table_[CONFIG::SC::IMLI_TABLE_SIZE];
+  std::vector<SC_Histories<CONFIG>> thread_histories_;
+  // The histories of the active thread.
+  SC_Histories<CONFIG>* histories_;
 
   Saturating_Counter<CONFIG::CONFIDENCE_COUNTER_WIDTH, true>
       first_high_confidence_ctr_;
@@ -288,6 +633,8 @@ class Statistical_Corrector {
       update_threshold_;
   Per_PC_Threshold_Table_Type p_update_thresholds_;
 
+  // The counters of all GEHLs, in the order of the GEHL members.
+  std::vector<Counter_Type> gehl_counters_;
   Gehl<CONFIG::SC::PRECISION,
        typename CONFIG::SC::GLOBAL_HISTORY_GEHL_HISTORIES,
        CONFIG::SC::LOG_SIZE_GLOBAL_HISTORY_GEHL>
@@ -310,6 +657,14 @@ class Statistical_Corrector {
   Gehl<CONFIG::SC::PRECISION, typename CONFIG::SC::SECOND_IMLI_GEHL_HISTORIES,
        CONFIG::SC::LOG_SIZE_SECOND_IMLI_GEHL>
       second_imli_gehl_;
+  static constexpr int num_gehl_counters_ =
+      decltype(global_history_gehl_)::num_counters +
+      decltype(path_gehl_)::num_counters +
+      decltype(first_local_gehl_)::num_counters +
+      decltype(second_local_gehl_)::num_counters +
+      decltype(third_local_gehl_)::num_counters +
+      decltype(first_imli_gehl_)::num_counters +
+      decltype(second_imli_gehl_)::num_counters;
 
   Variable_Threshold_Table_Type global_history_threshold_table_;
   Variable_Threshold_Table_Type path_threshold_table_;
@@ -323,26 +678,59 @@ class Statistical_Corrector {
   std::vector<Counter_Type> bias_table_;
   std::vector<Counter_Type> bias_sk_table_;
   std::vector<Counter_Type> bias_bank_table_;
+
+  Gehl_Sum_Kernel<
+      Counter_Type,
+      decltype(global_history_gehl_)::num_histories +
+          decltype(path_gehl_)::num_histories +
+          decltype(first_local_gehl_)::num_histories +
+          decltype(second_local_gehl_)::num_histories +
+          decltype(third_local_gehl_)::num_histories +
+          decltype(first_imli_gehl_)::num_histories +
+          decltype(second_imli_gehl_)::num_histories,
+      SC_NUM_COMPONENTS>
+      gehl_sum_kernel_;
+
+  // The confidence classes of the TAGE prediction that the statistics tell
+  // apart. A TAGE counter of magnitude |2 * c + 1| == 3 has none of the three
+  // confidence flags set.
+  enum Confidence_Class {
+    HIGH_CONFIDENCE,
+    MEDIUM_CONFIDENCE,
+    LOW_CONFIDENCE,
+    NO_CONFIDENCE_CLASS,
+    NUM_CONFIDENCE_CLASSES,
+  };
+
+  // Counters of committed branches by confidence class, only updated if
+  // CONFIG::SC::COLLECT_STATISTICS. A disagreement is a sum whose sign differs
+  // from the TAGE or loop prediction; an override is a final prediction that
+  // differs from it.
+  struct Statistics {
+    int64_t branches[NUM_CONFIDENCE_CLASSES] = {};
+    int64_t disagreements[NUM_CONFIDENCE_CLASSES] = {};
+    int64_t overrides[NUM_CONFIDENCE_CLASSES] = {};
+    int64_t correct_overrides[NUM_CONFIDENCE_CLASSES] = {};
+  };
+  Statistics statistics_;
 };
 
 template <class CONFIG>
-Statistical_Corrector<CONFIG>::Statistical_Corrector()
-    : first_local_history_table_(),
-      second_local_history_table_(),
-      third_local_history_table_(),
-      imli_counter_(0),
-      imli_table_(),
+Statistical_Corrector<CONFIG>::Statistical_Corrector(int num_threads)
+    : thread_histories_(num_threads),
+      histories_(&thread_histories_[0]),
       first_high_confidence_ctr_(0),
       second_high_confidence_ctr_(0),
       update_threshold_(CONFIG::SC::INITIAL_UPDATE_THRESHOLD),
       p_update_thresholds_(0),
-      global_history_gehl_(),
-      path_gehl_(),
-      first_local_gehl_(),
-      second_local_gehl_(),
-      third_local_gehl_(),
-      first_imli_gehl_(),
-      second_imli_gehl_(),
+      gehl_counters_(num_gehl_counters_),
+      global_history_gehl_(gehl_counters_.data()),
+      path_gehl_(global_history_gehl_.end()),
+      first_local_gehl_(path_gehl_.end()),
+      second_local_gehl_(first_local_gehl_.end()),
+      third_local_gehl_(second_local_gehl_.end()),
+      first_imli_gehl_(third_local_gehl_.end()),
+      second_imli_gehl_(first_imli_gehl_.end()),
       global_history_threshold_table_(CONFIG::SC::INITIAL_VARIABLE_THRESHOLD),
       path_threshold_table_(CONFIG::SC::INITIAL_VARIABLE_THRESHOLD),
       first_local_threshold_table_(CONFIG::SC::INITIAL_VARIABLE_THRESHOLD),
@@ -353,8 +741,28 @@ Statistical_Corrector<CONFIG>::Statistical_Corrector()
       bias_threshold_table_(CONFIG::SC::INITIAL_VARIABLE_THRESHOLD_FOR_BIAS),
       bias_table_(1 << CONFIG::SC::LOG_BIAS_ENTRIES, Counter_Type(0)),
       bias_sk_table_(1 << CONFIG::SC::LOG_BIAS_ENTRIES, Counter_Type(0)),
-      bias_bank_table_(1 << CONFIG::SC::LOG_BIAS_ENTRIES, Counter_Type(0)) {
+      bias_bank_table_(1 << CONFIG::SC::LOG_BIAS_ENTRIES, Counter_Type(0)),
+      gehl_sum_kernel_(gehl_counters_.data()) {
   initialize_bias_tables();
+  global_history_gehl_.add_kernel_lanes(&gehl_sum_kernel_,
+                                        SC_GLOBAL_HISTORY_GEHL);
+  path_gehl_.add_kernel_lanes(&gehl_sum_kernel_, SC_PATH_GEHL);
+  if (CONFIG::SC::USE_LOCAL_HISTORY) {
+    first_local_gehl_.add_kernel_lanes(&gehl_sum_kernel_, SC_FIRST_LOCAL_GEHL);
+    if (CONFIG::SC::USE_SECOND_LOCAL_HISTORY) {
+      second_local_gehl_.add_kernel_lanes(&gehl_sum_kernel_,
+                                          SC_SECOND_LOCAL_GEHL);
+    }
+    if (CONFIG::SC::USE_THIRD_LOCAL_HISTORY) {
+      third_local_gehl_.add_kernel_lanes(&gehl_sum_kernel_,
+                                         SC_THIRD_LOCAL_GEHL);
+    }
+  }
+  if (CONFIG::SC::USE_IMLI) {
+    first_imli_gehl_.add_kernel_lanes(&gehl_sum_kernel_, SC_FIRST_IMLI_GEHL);
+    second_imli_gehl_.add_kernel_lanes(&gehl_sum_kernel_,
+                                       SC_SECOND_IMLI_GEHL);
+  }
 }
 
 template <class CONFIG>
@@ -362,24 +770,55 @@ void Statistical_Corrector<CONFIG>::get_prediction(
     uint64_t br_pc,
     const Tage_Prediction_Info<typename CONFIG::TAGE>& tage_prediction_info,
     bool tage_or_loop_prediction, SC_Prediction_Info* prediction_info) {
+  // Compute the sums of all GEHL components at once.
+  uint64_t gehl_pcs[SC_NUM_COMPONENTS] = {};
+  int64_t gehl_histories[SC_NUM_COMPONENTS] = {};
+  gehl_pcs[SC_GLOBAL_HISTORY_GEHL] =
+      (br_pc << 1) + (tage_or_loop_prediction ? 1 : 0);
+  gehl_histories[SC_GLOBAL_HISTORY_GEHL] = histories_->global_history_;
+  gehl_pcs[SC_PATH_GEHL] = br_pc;
+  gehl_histories[SC_PATH_GEHL] = histories_->path_;
+  if (CONFIG::SC::USE_LOCAL_HISTORY) {
+    gehl_pcs[SC_FIRST_LOCAL_GEHL] = br_pc;
+    gehl_histories[SC_FIRST_LOCAL_GEHL] =
+        histories_->first_local_history_table_.get_history(br_pc);
+    if (CONFIG::SC::USE_SECOND_LOCAL_HISTORY) {
+      gehl_pcs[SC_SECOND_LOCAL_GEHL] = br_pc;
+      gehl_histories[SC_SECOND_LOCAL_GEHL] =
+          histories_->second_local_history_table_.get_history(br_pc);
+    }
+    if (CONFIG::SC::USE_THIRD_LOCAL_HISTORY) {
+      gehl_pcs[SC_THIRD_LOCAL_GEHL] = br_pc;
+      gehl_histories[SC_THIRD_LOCAL_GEHL] =
+          histories_->third_local_history_table_.get_history(br_pc);
+    }
+  }
+  if (CONFIG::SC::USE_IMLI) {
+    gehl_pcs[SC_FIRST_IMLI_GEHL] = br_pc;
+    gehl_histories[SC_FIRST_IMLI_GEHL] = histories_->imli_counter_.get();
+    gehl_pcs[SC_SECOND_IMLI_GEHL] = br_pc;
+    gehl_histories[SC_SECOND_IMLI_GEHL] = histories_->imli_history();
+  }
+  int* component_sums = prediction_info->component_sums;
+  gehl_sum_kernel_.compute_sums(gehl_pcs, gehl_histories, component_sums);
+
   int components_sum = 0;
   int thresholds_sum = (update_threshold_.get() >> 3) +
                        p_update_thresholds_.get_entry(br_pc).get();
 
-  // Add bias.
+  // Add bias, bias_sk and bias_bank.
   int bias_table_index = get_bias_table_index(br_pc, tage_prediction_info,
                                               tage_or_loop_prediction);
-  components_sum += 2 * bias_table_[bias_table_index].get() + 1;
-
-  // Add bias_sk.
   int bias_sk_table_index = get_bias_sk_table_index(br_pc, tage_prediction_info,
                                                     tage_or_loop_prediction);
-  components_sum += 2 * bias_sk_table_[bias_sk_table_index].get() + 1;
-
-  // Add bias_sk.
   int bias_bank_table_index = get_bias_bank_table_index(
       br_pc, tage_prediction_info, tage_or_loop_prediction);
-  components_sum += 2 * bias_bank_table_[bias_bank_table_index].get() + 1;
+  component_sums[SC_BIASES] = 2 * bias_table_[bias_table_index].get() + 1;
+  component_sums[SC_BIASES] +=
+      2 * bias_sk_table_[bias_sk_table_index].get() + 1;
+  component_sums[SC_BIASES] +=
+      2 * bias_bank_table_[bias_bank_table_index].get() + 1;
+  components_sum += component_sums[SC_BIASES];
 
   if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
     if (bias_threshold_table_.get_entry(br_pc).get() >= 0) {
@@ -390,10 +829,10 @@ void Statistical_Corrector<CONFIG>::get_prediction(
 
   // Add global history and path GEHL components.
   components_sum += get_gehl_prediction_sum(
-      global_history_gehl_, global_history_threshold_table_,
-      (br_pc << 1) + (tage_or_loop_prediction ? 1 : 0), global_history_);
-  components_sum +=
-      get_gehl_prediction_sum(path_gehl_, path_threshold_table_, br_pc, path_);
+      component_sums[SC_GLOBAL_HISTORY_GEHL], global_history_threshold_table_,
+      gehl_pcs[SC_GLOBAL_HISTORY_GEHL]);
+  components_sum += get_gehl_prediction_sum(component_sums[SC_PATH_GEHL],
+                                            path_threshold_table_, br_pc);
 
   if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
     thresholds_sum +=
@@ -403,19 +842,19 @@ void Statistical_Corrector<CONFIG>::get_prediction(
 
   // Add local history GEHL components.
   if (CONFIG::SC::USE_LOCAL_HISTORY) {
-    components_sum += get_gehl_prediction_sum(
-        first_local_gehl_, first_local_threshold_table_, br_pc,
-        first_local_history_table_.get_history(br_pc));
+    components_sum +=
+        get_gehl_prediction_sum(component_sums[SC_FIRST_LOCAL_GEHL],
+                                first_local_threshold_table_, br_pc);
 
     if (CONFIG::SC::USE_SECOND_LOCAL_HISTORY) {
-      components_sum += get_gehl_prediction_sum(
-          second_local_gehl_, second_local_threshold_table_, br_pc,
-          second_local_history_table_.get_history(br_pc));
+      components_sum +=
+          get_gehl_prediction_sum(component_sums[SC_SECOND_LOCAL_GEHL],
+                                  second_local_threshold_table_, br_pc);
     }
     if (CONFIG::SC::USE_THIRD_LOCAL_HISTORY) {
-      components_sum += get_gehl_prediction_sum(
-          third_local_gehl_, third_local_threshold_table_, br_pc,
-          third_local_history_table_.get_history(br_pc));
+      components_sum +=
+          get_gehl_prediction_sum(component_sums[SC_THIRD_LOCAL_GEHL],
+                                  third_local_threshold_table_, br_pc);
     }
   }
   if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
@@ -432,11 +871,11 @@ void Statistical_Corrector<CONFIG>::get_prediction(
   }
   if (CONFIG::SC::USE_IMLI) {
     components_sum +=
-        get_gehl_prediction_sum(second_imli_gehl_, second_imli_threshold_table_,
-                                br_pc, imli_table_[imli_counter_.get()]);
+        get_gehl_prediction_sum(component_sums[SC_SECOND_IMLI_GEHL],
+                                second_imli_threshold_table_, br_pc);
     components_sum +=
-        get_gehl_prediction_sum(first_imli_gehl_, first_imli_threshold_table_,
-                                br_pc, imli_counter_.get());
+        get_gehl_prediction_sum(component_sums[SC_FIRST_IMLI_GEHL],
+                                first_imli_threshold_table_, br_pc);
     if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
       thresholds_sum +=
           12 * (first_imli_threshold_table_.get_entry(br_pc).get() >= 0);
@@ -513,8 +952,21 @@ void Statistical_Corrector<CONFIG>::commit_state(
     const Tage_Prediction_Info<typename CONFIG::TAGE>& tage_prediction_info,
     const SC_Prediction_Info& sc_prediction_info,
     bool tage_or_loop_prediction) {
-  imli_table_[imli_counter_.get()];
   bool sc_prediction = (sc_prediction_info.gehls_sum >= 0);
+  if (CONFIG::SC::COLLECT_STATISTICS) {
+    Confidence_Class confidence_class =
+        tage_prediction_info.high_confidence     ? HIGH_CONFIDENCE
+        : tage_prediction_info.medium_confidence ? MEDIUM_CONFIDENCE
+        : tage_prediction_info.low_confidence    ? LOW_CONFIDENCE
+                                                 : NO_CONFIDENCE_CLASS;
+    bool overridden = sc_prediction_info.prediction != tage_or_loop_prediction;
+    statistics_.branches[confidence_class] += 1;
+    statistics_.disagreements[confidence_class] +=
+        sc_prediction != tage_or_loop_prediction;
+    statistics_.overrides[confidence_class] += overridden;
+    statistics_.correct_overrides[confidence_class] +=
+        overridden && sc_prediction_info.prediction == resolve_dir;
+  }
   if (tage_or_loop_prediction != sc_prediction) {
     // REVIST: the first if statement seems to be redundant
     if (std::abs(sc_prediction_info.gehls_sum) <
@@ -554,10 +1006,9 @@ void Statistical_Corrector<CONFIG>::commit_state(
     int bias_bank_table_index = get_bias_bank_table_index(
         br_pc, tage_prediction_info, tage_or_loop_prediction);
 
+    const int* component_sums = sc_prediction_info.component_sums;
     if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
-      int biases_sum = 2 * bias_table_[bias_table_index].get() + 1;
-      biases_sum += 2 * bias_sk_table_[bias_sk_table_index].get() + 1;
-      biases_sum += 2 * bias_bank_table_[bias_bank_table_index].get() + 1;
+      int biases_sum = component_sums[SC_BIASES];
 
       int gehls_sum_without_doubled_biases =
           sc_prediction_info.gehls_sum -
@@ -580,27 +1031,30 @@ void Statistical_Corrector<CONFIG>::commit_state(
         &global_history_gehl_, &global_history_threshold_table_,
         (br_pc << 1) + (tage_or_loop_prediction ? 1 : 0),
         sc_prediction_info.history_snapshot.global_history, resolve_dir,
-        sc_prediction_info.gehls_sum);
+        sc_prediction_info.gehls_sum, component_sums[SC_GLOBAL_HISTORY_GEHL]);
     update_gehl_and_threshold(&path_gehl_, &path_threshold_table_, br_pc,
                               sc_prediction_info.history_snapshot.path,
-                              resolve_dir, sc_prediction_info.gehls_sum);
+                              resolve_dir, sc_prediction_info.gehls_sum,
+                              component_sums[SC_PATH_GEHL]);
 
     if (CONFIG::SC::USE_LOCAL_HISTORY) {
       update_gehl_and_threshold(
           &first_local_gehl_, &first_local_threshold_table_, br_pc,
           sc_prediction_info.history_snapshot.first_local_history, resolve_dir,
-          sc_prediction_info.gehls_sum);
+          sc_prediction_info.gehls_sum, component_sums[SC_FIRST_LOCAL_GEHL]);
       if (CONFIG::SC::USE_SECOND_LOCAL_HISTORY) {
         update_gehl_and_threshold(
             &second_local_gehl_, &second_local_threshold_table_, br_pc,
             sc_prediction_info.history_snapshot.second_local_history,
-            resolve_dir, sc_prediction_info.gehls_sum);
+            resolve_dir, sc_prediction_info.gehls_sum,
+            component_sums[SC_SECOND_LOCAL_GEHL]);
       }
       if (CONFIG::SC::USE_THIRD_LOCAL_HISTORY) {
         update_gehl_and_threshold(
             &third_local_gehl_, &third_local_threshold_table_, br_pc,
             sc_prediction_info.history_snapshot.third_local_history,
-            resolve_dir, sc_prediction_info.gehls_sum);
+            resolve_dir, sc_prediction_info.gehls_sum,
+            component_sums[SC_THIRD_LOCAL_GEHL]);
       }
     }
 
@@ -608,11 +1062,11 @@ void Statistical_Corrector<CONFIG>::commit_state(
       update_gehl_and_threshold(
           &second_imli_gehl_, &second_imli_threshold_table_, br_pc,
           sc_prediction_info.history_snapshot.imli_local_history, resolve_dir,
-          sc_prediction_info.gehls_sum);
+          sc_prediction_info.gehls_sum, component_sums[SC_SECOND_IMLI_GEHL]);
       update_gehl_and_threshold(
           &first_imli_gehl_, &first_imli_threshold_table_, br_pc,
           sc_prediction_info.history_snapshot.imli_counter, resolve_dir,
-          sc_prediction_info.gehls_sum);
+          sc_prediction_info.gehls_sum, component_sums[SC_FIRST_IMLI_GEHL]);
     }
   }
 }
@@ -621,54 +1075,56 @@ template <class CONFIG>
 void Statistical_Corrector<CONFIG>::update_speculative_state(
     uint64_t br_pc, bool resolve_dir, uint64_t br_target, Branch_Type br_type,
     SC_Prediction_Info* prediction_info) {
-  prediction_info->history_snapshot.global_history = global_history_;
-  prediction_info->history_snapshot.path = path_;
+  prediction_info->history_snapshot.global_history =
+      histories_->global_history_;
+  prediction_info->history_snapshot.path = histories_->path_;
   if (CONFIG::SC::USE_LOCAL_HISTORY) {
     prediction_info->history_snapshot.first_local_history =
-        first_local_history_table_.get_history(br_pc);
+        histories_->first_local_history_table_.get_history(br_pc);
     if (CONFIG::SC::USE_SECOND_LOCAL_HISTORY) {
       prediction_info->history_snapshot.second_local_history =
-          second_local_history_table_.get_history(br_pc);
+          histories_->second_local_history_table_.get_history(br_pc);
     }
     if (CONFIG::SC::USE_THIRD_LOCAL_HISTORY) {
       prediction_info->history_snapshot.third_local_history =
-          third_local_history_table_.get_history(br_pc);
+          histories_->third_local_history_table_.get_history(br_pc);
     }
   }
   if (CONFIG::SC::USE_IMLI) {
-    prediction_info->history_snapshot.imli_counter = imli_counter_.get();
+    prediction_info->history_snapshot.imli_counter =
+        histories_->imli_counter_.get();
     prediction_info->history_snapshot.imli_local_history =
-        imli_table_[imli_counter_.get()];
+        histories_->imli_history();
   }
 
   if ((br_type.is_conditional) && CONFIG::SC::USE_IMLI) {
-    int table_index = imli_counter_.get();
-    imli_table_[table_index] = (imli_table_[table_index] << 1) + resolve_dir;
+    int64_t& imli_history = histories_->imli_history();
+    imli_history = (imli_history << 1) + resolve_dir;
     if (br_target < br_pc) {
       // This branch corresponds to a loop
       if (!resolve_dir) {
         // exit of the "loop"
-        imli_counter_.set(0);
+        histories_->imli_counter_.set(0);
       } else {
-        imli_counter_.increment();
+        histories_->imli_counter_.increment();
       }
     }
   }
 
   if (br_type.is_conditional) {
-    global_history_ =
-        (global_history_ << 1) + (resolve_dir & (br_target < br_pc));
+    histories_->global_history_ = (histories_->global_history_ << 1) +
+                                  (resolve_dir & (br_target < br_pc));
     int64_t& first_local_history =
-        first_local_history_table_.get_history(br_pc);
+        histories_->first_local_history_table_.get_history(br_pc);
     first_local_history = (first_local_history << 1) + resolve_dir;
 
     int64_t& second_local_history =
-        second_local_history_table_.get_history(br_pc);
+        histories_->second_local_history_table_.get_history(br_pc);
     second_local_history =
         ((second_local_history << 1) + resolve_dir) ^ (br_pc & 15);
 
     int64_t& third_local_history =
-        third_local_history_table_.get_history(br_pc);
+        histories_->third_local_history_table_.get_history(br_pc);
     third_local_history = (third_local_history << 1) + resolve_dir;
   }
 
@@ -687,10 +1143,10 @@ void Statistical_Corrector<CONFIG>::update_speculative_state(
   }
 
   for (int i = 0; i < num_bit_inserts; ++i) {
-    path_ = (path_ << 1) ^ (path_hash & 127);
+    histories_->path_ = (histories_->path_ << 1) ^ (path_hash & 127);
     path_hash >>= 1;
   }
-  path_ = path_ & ((1 << CONFIG::SC::SC_PATH_HISTORY_WIDTH) - 1);
+  histories_->path_ &= (1 << CONFIG::SC::SC_PATH_HISTORY_WIDTH) - 1;
 }
 
 template <class CONFIG>
@@ -770,6 +1226,118 @@ int Statistical_Corrector<CONFIG>::get_bias_bank_table_index(
   return index;
 }
 
+template <class CONFIG>
+void Statistical_Corrector<CONFIG>::save_state(State_Writer* writer) const {
+  histories_->save_state(writer);
+  writer->write(first_high_confidence_ctr_);
+  writer->write(second_high_confidence_ctr_);
+  writer->write(update_threshold_);
+  p_update_thresholds_.save_state(writer);
+  global_history_gehl_.save_state(writer);
+  path_gehl_.save_state(writer);
+  first_local_gehl_.save_state(writer);
+  second_local_gehl_.save_state(writer);
+  third_local_gehl_.save_state(writer);
+  first_imli_gehl_.save_state(writer);
+  second_imli_gehl_.save_state(writer);
+  global_history_threshold_table_.save_state(writer);
+  path_threshold_table_.save_state(writer);
+  first_local_threshold_table_.save_state(writer);
+  second_local_threshold_table_.save_state(writer);
+  third_local_threshold_table_.save_state(writer);
+  first_imli_threshold_table_.save_state(writer);
+  second_imli_threshold_table_.save_state(writer);
+  bias_threshold_table_.save_state(writer);
+  writer->write(bias_table_.data(), bias_table_.size());
+  writer->write(bias_sk_table_.data(), bias_sk_table_.size());
+  writer->write(bias_bank_table_.data(), bias_bank_table_.size());
+}
+
+template <class CONFIG>
+void Statistical_Corrector<CONFIG>::load_state(State_Reader* reader) {
+  histories_->load_state(reader);
+  for (auto& histories : thread_histories_) {
+    histories = *histories_;
+  }
+  reader->read(&first_high_confidence_ctr_);
+  reader->read(&second_high_confidence_ctr_);
+  reader->read(&update_threshold_);
+  p_update_thresholds_.load_state(reader);
+  global_history_gehl_.load_state(reader);
+  path_gehl_.load_state(reader);
+  first_local_gehl_.load_state(reader);
+  second_local_gehl_.load_state(reader);
+  third_local_gehl_.load_state(reader);
+  first_imli_gehl_.load_state(reader);
+  second_imli_gehl_.load_state(reader);
+  global_history_threshold_table_.load_state(reader);
+  path_threshold_table_.load_state(reader);
+  first_local_threshold_table_.load_state(reader);
+  second_local_threshold_table_.load_state(reader);
+  third_local_threshold_table_.load_state(reader);
+  first_imli_threshold_table_.load_state(reader);
+  second_imli_threshold_table_.load_state(reader);
+  bias_threshold_table_.load_state(reader);
+  reader->read(bias_table_.data(), bias_table_.size());
+  reader->read(bias_sk_table_.data(), bias_sk_table_.size());
+  reader->read(bias_bank_table_.data(), bias_bank_table_.size());
+}
+
+template <class CONFIG>
+void Statistical_Corrector<CONFIG>::fingerprint_config(
+    Config_Fingerprint* fingerprint) {
+  using SC = typename CONFIG::SC;
+  for (int64_t value :
+       {SC::UPDATE_THRESHOLD_WIDTH, SC::PERPC_UPDATE_THRESHOLD_WIDTH,
+        SC::INITIAL_UPDATE_THRESHOLD, SC::LOG_SIZE_PERPC_THRESHOLD_TABLE,
+        SC::LOG_SIZE_VARIABLE_THRESHOLD_TABLE, SC::VARIABLE_THRESHOLD_WIDTH,
+        SC::INITIAL_VARIABLE_THRESHOLD,
+        SC::INITIAL_VARIABLE_THRESHOLD_FOR_BIAS, SC::LOG_BIAS_ENTRIES,
+        SC::LOG_SIZE_GLOBAL_HISTORY_GEHL, SC::LOG_SIZE_PATH_GEHL,
+        SC::FIRST_LOCAL_HISTORY_LOG_TABLE_SIZE, SC::FIRST_LOCAL_HISTORY_SHIFT,
+        SC::LOG_SIZE_FIRST_LOCAL_GEHL, SC::SECOND_LOCAL_HISTORY_LOG_TABLE_SIZE,
+        SC::SECOND_LOCAL_HISTORY_SHIFT, SC::LOG_SIZE_SECOND_LOCAL_GEHL,
+        SC::THIRD_LOCAL_HISTORY_LOG_TABLE_SIZE, SC::THIRD_LOCAL_HISTORY_SHIFT,
+        SC::LOG_SIZE_THIRD_LOCAL_GEHL, SC::IMLI_COUNTER_WIDTH,
+        SC::IMLI_TABLE_SIZE, SC::log_size_first_imli_gehl,
+        SC::LOG_SIZE_SECOND_IMLI_GEHL, SC::PRECISION,
+        SC::SC_PATH_HISTORY_WIDTH}) {
+    fingerprint->add(value);
+  }
+  for (bool flag : {SC::USE_VARIABLE_THRESHOLD, SC::USE_LOCAL_HISTORY,
+                    SC::USE_SECOND_LOCAL_HISTORY, SC::USE_THIRD_LOCAL_HISTORY,
+                    SC::USE_IMLI}) {
+    fingerprint->add(flag);
+  }
+  fingerprint->add_array<typename SC::GLOBAL_HISTORY_GEHL_HISTORIES>();
+  fingerprint->add_array<typename SC::PATH_GEHL_HISTORIES>();
+  fingerprint->add_array<typename SC::FIRST_LOCAL_GEHL_HISTORIES>();
+  fingerprint->add_array<typename SC::SECOND_LOCAL_GEHL_HISTORIES>();
+  fingerprint->add_array<typename SC::THIRD_LOCAL_GEHL_HISTORIES>();
+  fingerprint->add_array<typename SC::FIRST_IMLI_GEHL_HISTORIES>();
+  fingerprint->add_array<typename SC::SECOND_IMLI_GEHL_HISTORIES>();
+}
+
+template <class CONFIG>
+void Statistical_Corrector<CONFIG>::append_statistics(
+    std::vector<Statistic>* statistics) const {
+  if (!CONFIG::SC::COLLECT_STATISTICS) {
+    return;
+  }
+  static const char* const confidence_class_names[] = {
+      "high_confidence", "medium_confidence", "low_confidence",
+      "no_confidence_class"};
+  for (int i = 0; i < NUM_CONFIDENCE_CLASSES; ++i) {
+    std::string prefix = std::string("sc/") + confidence_class_names[i] + "/";
+    statistics->insert(
+        statistics->end(),
+        {{prefix + "branches", statistics_.branches[i]},
+         {prefix + "disagreements", statistics_.disagreements[i]},
+         {prefix + "overrides", statistics_.overrides[i]},
+         {prefix + "correct_overrides", statistics_.correct_overrides[i]}});
+  }
+}
+
 }  // namespace tagescl
 
 #endif  // SPEC_TAGE_SC_L_STATISTICAL_CORRECTOR_HPP_
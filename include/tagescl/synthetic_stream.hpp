@@ -0,0 +1,304 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPEC_TAGE_SC_L_SYNTHETIC_STREAM_HPP_
+#define SPEC_TAGE_SC_L_SYNTHETIC_STREAM_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace tagescl {
+
+// Parameters of a Synthetic_Branch_Stream. The stream is a sequence of code
+// regions of the kinds below, chosen at random with the given weights.
+struct Synthetic_Stream_Config {
+  uint64_t seed = 1;
+
+  // Loops: a backward conditional branch taken trip_count - 1 times in a row,
+  // with loop_body_branches periodic branches inside. The trip count of a
+  // loop is fixed, except for variable_trip_count_percent of the loops, which
+  // draw a new one on every visit.
+  int loop_weight = 4;
+  int num_loops = 64;
+  int min_trip_count = 2;
+  int max_trip_count = 64;
+  int variable_trip_count_percent = 10;
+  int loop_body_branches = 2;
+
+  // Correlated chains: a random branch followed by chain_length - 1 branches
+  // whose outcomes are fixed functions of earlier outcomes of the chain.
+  int chain_weight = 3;
+  int num_chains = 64;
+  int chain_length = 6;
+
+  // Indirect jumps: a random conditional branch followed by an indirect jump
+  // whose target depends on its outcome and on the number of visits.
+  int indirect_weight = 1;
+  int num_indirect_branches = 16;
+  int num_indirect_targets = 8;
+
+  // Calls: a call, a function body of biased branches that may call other
+  // functions (up to max_call_depth), and the return.
+  int call_weight = 2;
+  int num_functions = 32;
+  int function_body_branches = 3;
+  int max_call_depth = 8;
+
+  // Noise: branches taken with probability noise_taken_percent / 100.
+  int noise_weight = 1;
+  int num_noise_branches = 64;
+  int noise_taken_percent = 50;
+
+  // Number of instructions from one branch to the next.
+  int min_block_size = 1;
+  int max_block_size = 12;
+};
+
+/* A deterministic generator of branches with the behaviours of real programs,
+ * to test and benchmark predictors without traces. The same configuration
+ * produces the same stream on every platform. */
+class Synthetic_Branch_Stream {
+ public:
+  explicit Synthetic_Branch_Stream(const Synthetic_Stream_Config& config)
+      : config_(config), random_state_(config.seed) {
+    assert(config_.min_trip_count >= 1 &&
+           config_.min_trip_count <= config_.max_trip_count);
+    assert(config_.chain_length >= 1);
+    assert(config_.num_indirect_targets >= 1);
+    assert(config_.min_block_size >= 1 &&
+           config_.min_block_size <= config_.max_block_size);
+    loops_.resize(config_.num_loops);
+    for (Loop& loop : loops_) {
+      loop.trip_count = random_trip_count();
+      loop.variable_trip_count =
+          random_below(100) < static_cast<uint64_t>(
+                                  config_.variable_trip_count_percent);
+    }
+    chain_links_.resize(config_.num_chains * config_.chain_length);
+    for (int i = 0; i < config_.num_chains; ++i) {
+      for (int j = 1; j < config_.chain_length; ++j) {
+        Chain_Link& link = chain_links_[i * config_.chain_length + j];
+        link.source = static_cast<int>(random_below(j));
+        link.negate = random_below(2);
+      }
+    }
+    indirect_visits_.resize(config_.num_indirect_branches);
+    function_biases_.resize(config_.num_functions *
+                            config_.function_body_branches);
+    for (std::size_t i = 0; i < function_biases_.size(); ++i) {
+      function_biases_[i] = random_below(2);
+    }
+  }
+
+  // Returns the next branch of the stream.
+  Branch_Record next() {
+    if (next_pending_ == pending_.size()) {
+      pending_.clear();
+      next_pending_ = 0;
+      generate_region();
+    }
+    instruction_number_ += config_.min_block_size +
+                           random_below(config_.max_block_size -
+                                        config_.min_block_size + 1);
+    return pending_[next_pending_++];
+  }
+
+  // Returns the next num_branches branches of the stream.
+  std::vector<Branch_Record> generate(std::size_t num_branches) {
+    std::vector<Branch_Record> branches(num_branches);
+    for (Branch_Record& branch : branches) {
+      branch = next();
+    }
+    return branches;
+  }
+
+  // Number of instructions up to the last branch returned, counting it.
+  int64_t instruction_number() const { return instruction_number_; }
+
+ private:
+  struct Loop {
+    int trip_count;
+    bool variable_trip_count;
+  };
+
+  struct Chain_Link {
+    int source;
+    bool negate;
+  };
+
+  // Disjoint address ranges for each kind of region.
+  static constexpr uint64_t loops_base_ = 0x10000;
+  static constexpr uint64_t chains_base_ = 0x200000;
+  static constexpr uint64_t indirects_base_ = 0x400000;
+  static constexpr uint64_t call_sites_base_ = 0x600000;
+  static constexpr uint64_t functions_base_ = 0x800000;
+  static constexpr uint64_t noise_base_ = 0xA00000;
+  static constexpr uint64_t region_stride_ = 0x400;
+  static constexpr uint64_t function_stride_ = 0x1000;
+
+  // SplitMix64, so that the stream does not depend on the standard library.
+  uint64_t random() {
+    uint64_t z = (random_state_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t random_below(uint64_t bound) { return random() % bound; }
+
+  int random_trip_count() {
+    return config_.min_trip_count +
+           static_cast<int>(random_below(config_.max_trip_count -
+                                         config_.min_trip_count + 1));
+  }
+
+  void emit(uint64_t br_pc, uint64_t br_target, bool is_conditional,
+            bool is_indirect, bool taken) {
+    Branch_Record branch;
+    branch.br_pc = br_pc;
+    branch.br_target = br_target;
+    branch.br_type.is_conditional = is_conditional;
+    branch.br_type.is_indirect = is_indirect;
+    branch.resolve_dir = taken;
+    pending_.push_back(branch);
+  }
+
+  void emit_conditional(uint64_t br_pc, bool taken) {
+    emit(br_pc, br_pc + 0x20, true, false, taken);
+  }
+
+  void generate_region() {
+    const int weights[] = {config_.loop_weight, config_.chain_weight,
+                           config_.indirect_weight, config_.call_weight,
+                           config_.noise_weight};
+    const bool available[] = {
+        config_.num_loops > 0, config_.num_chains > 0,
+        config_.num_indirect_branches > 0, config_.num_functions > 0,
+        config_.num_noise_branches > 0};
+    int total_weight = 0;
+    for (int i = 0; i < 5; ++i) {
+      total_weight += available[i] ? weights[i] : 0;
+    }
+    assert(total_weight > 0);
+    int choice = static_cast<int>(random_below(total_weight));
+    int kind = 0;
+    while (!available[kind] || choice >= weights[kind]) {
+      choice -= available[kind] ? weights[kind] : 0;
+      ++kind;
+    }
+    switch (kind) {
+      case 0:
+        generate_loop(random_below(config_.num_loops));
+        break;
+      case 1:
+        generate_chain(random_below(config_.num_chains));
+        break;
+      case 2:
+        generate_indirect(random_below(config_.num_indirect_branches));
+        break;
+      case 3:
+        generate_call(random_below(config_.num_functions), 1);
+        break;
+      default:
+        generate_noise(random_below(config_.num_noise_branches));
+        break;
+    }
+  }
+
+  void generate_loop(uint64_t id) {
+    Loop& loop = loops_[id];
+    if (loop.variable_trip_count) {
+      loop.trip_count = random_trip_count();
+    }
+    uint64_t head = loops_base_ + id * region_stride_;
+    uint64_t back_edge = head + region_stride_ - 0x10;
+    for (int iter = 0; iter < loop.trip_count; ++iter) {
+      for (int i = 0; i < config_.loop_body_branches; ++i) {
+        emit_conditional(head + 0x10 * i, iter % (i + 2) == 0);
+      }
+      emit(back_edge, head, true, false, iter + 1 < loop.trip_count);
+    }
+  }
+
+  void generate_chain(uint64_t id) {
+    uint64_t base = chains_base_ + id * region_stride_;
+    const Chain_Link* links = &chain_links_[id * config_.chain_length];
+    outcomes_.resize(config_.chain_length);
+    outcomes_[0] = random_below(2);
+    emit_conditional(base, outcomes_[0]);
+    for (int i = 1; i < config_.chain_length; ++i) {
+      outcomes_[i] = outcomes_[links[i].source] != links[i].negate;
+      emit_conditional(base + 0x10 * i, outcomes_[i]);
+    }
+  }
+
+  void generate_indirect(uint64_t id) {
+    uint64_t base = indirects_base_ + id * region_stride_;
+    bool selector = random_below(2);
+    emit_conditional(base, selector);
+    uint64_t target_id =
+        (indirect_visits_[id]++ + selector) % config_.num_indirect_targets;
+    emit(base + 0x10, base + 0x40 + 0x10 * target_id, false, true, true);
+  }
+
+  void generate_call(uint64_t id, int depth) {
+    uint64_t call_site = call_sites_base_ + id * 0x10;
+    uint64_t entry = functions_base_ + id * function_stride_;
+    emit(call_site, entry, false, false, true);
+    for (int i = 0; i < config_.function_body_branches; ++i) {
+      // Biased, with one mispredicted outcome in 16.
+      bool bias = function_biases_[id * config_.function_body_branches + i];
+      emit_conditional(entry + 0x10 * i, bias != (random_below(16) == 0));
+    }
+    if (depth < config_.max_call_depth && random_below(2)) {
+      generate_call((id * 7 + 1) % config_.num_functions, depth + 1);
+    }
+    emit(entry + function_stride_ - 0x10, call_site + 4, false, true, true);
+  }
+
+  void generate_noise(uint64_t id) {
+    emit_conditional(noise_base_ + id * 0x10,
+                     random_below(100) <
+                         static_cast<uint64_t>(config_.noise_taken_percent));
+  }
+
+  Synthetic_Stream_Config config_;
+  uint64_t random_state_;
+  int64_t instruction_number_ = 0;
+
+  std::vector<Loop> loops_;
+  std::vector<Chain_Link> chain_links_;
+  std::vector<uint64_t> indirect_visits_;
+  std::vector<bool> function_biases_;
+  std::vector<bool> outcomes_;
+
+  // Branches of the current region not returned yet.
+  std::vector<Branch_Record> pending_;
+  std::size_t next_pending_ = 0;
+};
+
+}  // namespace tagescl
+
+#endif  // SPEC_TAGE_SC_L_SYNTHETIC_STREAM_HPP_
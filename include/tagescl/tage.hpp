@@ -22,42 +22,66 @@
 #ifndef SPEC_TAGE_SC_L_TAGE_HPP_
 #define SPEC_TAGE_SC_L_TAGE_HPP_
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "state_file.hpp"
 #include "utils.hpp"
 
 namespace tagescl {
 
 /* The main history register suitable for very large history. The history is
- * implemented as a circular buffer for efficiency. The API only allows
- * insertions of bits into the most recent position of the history and provides
- * an accessor for random access of individual bits. It also provides an API for
- * rewinding the history to support recovery from mispeculation */
+ * implemented as a circular buffer of 64-bit words for efficiency. The API only
+ * allows insertions of bits into the most recent position of the history and
+ * provides accessors for random access of individual bits or of a run of
+ * consecutive bits. It also provides an API for rewinding the history to
+ * support recovery from mispeculation */
 template <int history_size>
 class Long_History_Register {
  public:
   // Buffer_size needs to be a power of 2. (buffer_size - history_size) should
   // be large enough to cover speculative branches that are not yet retired.
-  Long_History_Register(int max_in_flight_bits) : history_bits_() {
-    int log_buffer_size =
-        get_min_num_bits_to_represent(history_size + max_in_flight_bits);
-    buffer_size_ = 1 << log_buffer_size;
-    buffer_access_mask_ = (1 << log_buffer_size) - 1;
+  Long_History_Register(int max_in_flight_bits) : history_words_() {
+    int log_buffer_size = std::max(
+        get_min_num_bits_to_represent(history_size + max_in_flight_bits),
+        log_word_size_);
+    buffer_size_ = int64_t{1} << log_buffer_size;
+    buffer_access_mask_ = buffer_size_ - 1;
     max_num_speculative_bits_ = buffer_size_ - history_size;
-    history_bits_.resize(buffer_size_);
+    history_words_.resize(buffer_size_ >> log_word_size_);
+    word_access_mask_ = history_words_.size() - 1;
   }
 
   // Pushes one bit into the history at the head. Increments
   // num_speculative_bits_
   // (saturated at max_num_speculative_bits_).
-  void push_bit(bool bit) {
+  void push_bit(bool bit) { push_bits(bit, 1); }
+
+  // Pushes the num_bits least significant bits of bits into the history,
+  // starting from the least significant one. That is, it is equivalent to
+  // calling push_bit() num_bits times while shifting bits to the right.
+  void push_bits(uint64_t bits, int num_bits) {
+    assert(num_bits > 0 && num_bits <= word_size_);
+    // The most recent bit has to end up at the head, which is the lowest
+    // position of the buffer, so the bits are stored in reverse order.
+    uint64_t reversed_bits = 0;
+    for (int i = 0; i < num_bits; ++i) {
+      reversed_bits = (reversed_bits << 1) | ((bits >> i) & 1);
+    }
+
     // TODO: it will be cleaner to mask head_ with (size_ - 1) now. But I
     // want to keep it compatible with Seznec.
-    head_ -= 1;
-    history_bits_[head_ & buffer_access_mask_] = bit;
+    head_ -= num_bits;
+    write_bits(head_ & buffer_access_mask_, reversed_bits, num_bits);
 
-    num_speculative_bits_ += 1;
+    num_speculative_bits_ += num_bits;
     assert(num_speculative_bits_ <= max_num_speculative_bits_);
   }
 
@@ -76,76 +100,386 @@ class Long_History_Register {
   }
 
   // Random access interface, i=0 is the most recent branch (head).
-  bool operator[](size_t i) const {
-    return history_bits_[(head_ + i) & buffer_access_mask_];
+  bool operator[](size_t i) const { return get_bits(i, 1); }
+
+  // Returns num_bits consecutive bits of the history starting at position i.
+  // Bit k of the result is the bit at position i + k, i.e. (*this)[i + k].
+  uint64_t get_bits(size_t i, int num_bits) const {
+    assert(num_bits > 0 && num_bits <= word_size_);
+    int64_t position = (head_ + i) & buffer_access_mask_;
+    int64_t word = position >> log_word_size_;
+    int offset = position & (word_size_ - 1);
+    uint64_t bits = history_words_[word] >> offset;
+    if (offset + num_bits > word_size_) {
+      bits |= history_words_[(word + 1) & word_access_mask_]
+              << (word_size_ - offset);
+    }
+    if (num_bits < word_size_) {
+      bits &= (uint64_t{1} << num_bits) - 1;
+    }
+    return bits;
   }
 
   const int64_t& head_idx() const { return head_; }
 
+  // Raw access to the buffer. Bit p of the buffer is bit (p % 64) of word
+  // (p / 64), and position i of the history is at bit
+  // (head_position() + i) & buffer_access_mask().
+  const uint64_t* data() const { return history_words_.data(); }
+  int64_t head_position() const { return head_ & buffer_access_mask_; }
+  int64_t buffer_access_mask() const { return buffer_access_mask_; }
+
   const int64_t& commit_head_idx() const { return commit_head_; }
 
+  // Saves the head indices and the history_size most recent bits, which do
+  // not depend on the size of the buffer. There should be no speculative
+  // bits.
+  void save_state(State_Writer* writer) const {
+    assert(num_speculative_bits_ == 0);
+    writer->write(head_);
+    writer->write(commit_head_);
+    uint64_t words[num_saved_words_];
+    for (int i = 0; i < num_saved_words_; ++i) {
+      words[i] = get_bits(i * word_size_, word_size_);
+    }
+    writer->write(words, num_saved_words_);
+  }
+
+  void load_state(State_Reader* reader) {
+    reader->read(&head_);
+    reader->read(&commit_head_);
+    num_speculative_bits_ = 0;
+    uint64_t words[num_saved_words_] = {};
+    reader->read(words, num_saved_words_);
+    std::fill(history_words_.begin(), history_words_.end(), 0);
+    for (int i = 0; i < num_saved_words_; ++i) {
+      write_bits((head_ + i * word_size_) & buffer_access_mask_, words[i],
+                 word_size_);
+    }
+  }
+
  private:
+  static constexpr int log_word_size_ = 6;
+  static constexpr int word_size_ = 1 << log_word_size_;
+  static constexpr int num_saved_words_ =
+      (history_size + word_size_ - 1) / word_size_;
+
+  // Overwrites num_bits bits of the buffer starting at position.
+  void write_bits(int64_t position, uint64_t bits, int num_bits) {
+    int64_t word = position >> log_word_size_;
+    int offset = position & (word_size_ - 1);
+    uint64_t mask = num_bits < word_size_ ? (uint64_t{1} << num_bits) - 1
+                                          : ~uint64_t{0};
+    history_words_[word] =
+        (history_words_[word] & ~(mask << offset)) | (bits << offset);
+    if (offset + num_bits > word_size_) {
+      int64_t next_word = (word + 1) & word_access_mask_;
+      int spilled_bits = offset + num_bits - word_size_;
+      uint64_t spilled_mask = (uint64_t{1} << spilled_bits) - 1;
+      history_words_[next_word] =
+          (history_words_[next_word] & ~spilled_mask) |
+          (bits >> (word_size_ - offset));
+    }
+  }
+
   int num_speculative_bits_ = 0;  // keeps track of how many bits can be
                                   // discarded during a rewind without losing
                                   // bits in the most significant position.
-  std::vector<bool> history_bits_;
+  std::vector<uint64_t> history_words_;
   int64_t head_ = 0;
   int64_t commit_head_ = 0;
   int64_t buffer_size_;
   int64_t buffer_access_mask_;
+  int64_t word_access_mask_;
   int64_t max_num_speculative_bits_;
 };
 
-/* Computes the a folded history of a large history, as bits are shifted into
- * the history. The caller should update the folded history everytime  */
-template <int history_size>
-class Folded_History {
+/* A copy of the values of the folded histories of a Folded_History_Bank. It is
+ * empty if the checkpoints are not enabled, although a member of an empty type
+ * still takes one byte, plus padding. */
+template <int num_folds, bool enabled>
+struct Folded_History_Checkpoint {
+  int32_t values[num_folds];
+};
+
+template <int num_folds>
+struct Folded_History_Checkpoint<num_folds, false> {};
+
+/* Computes the folded histories of a large history, as bits are shifted into
+ * the history. Each folded history compresses the most recent original_length
+ * bits of the history into compressed_length bits. The state of all the folded
+ * histories is kept in contiguous arrays so that they can be updated together,
+ * using SIMD instructions when the target supports AVX2 or AVX-512. The scalar
+ * implementation produces the same values. The caller should update the folded
+ * histories everytime bits are inserted into the history, and before they are
+ * rewound. */
+template <int history_size, int num_folds>
+class Folded_History_Bank {
  public:
-  Folded_History(int original_length, int compressed_length)
-      : current_value_(0),
-        original_length_(original_length),
-        compressed_length_(compressed_length),
-        outpoint_(original_length % compressed_length) {}
+  Folded_History_Bank()
+      : current_values_(),
+        original_lengths_(),
+        compressed_lengths_(),
+        outpoints_() {
+    // Padding lanes are updated along with the rest but never read.
+    for (int i = 0; i < padded_num_folds_; ++i) {
+      compressed_lengths_[i] = 1;
+    }
+  }
 
-  int64_t get_value() const { return current_value_; }
+  void set_fold(int fold, int original_length, int compressed_length) {
+    assert(0 <= fold && fold < num_folds);
+    assert(0 < compressed_length && compressed_length < 32);
+    current_values_[fold] = 0;
+    original_lengths_[fold] = original_length;
+    compressed_lengths_[fold] = compressed_length;
+    outpoints_[fold] = original_length % compressed_length;
+  }
 
-  void update(const Long_History_Register<history_size>& history_register) {
-    // Shift in the most recent GHR bit.
-    current_value_ = (current_value_ << 1) ^ history_register[0];
+  int64_t get_value(int fold) const { return current_values_[fold]; }
 
-    // Shift out the least recent GHR bit.
-    current_value_ ^= history_register[original_length_] << outpoint_;
+  // Saves and restores the values of all folded histories. Restoring a
+  // checkpoint only makes sense if the history is rewound to the position it
+  // had when the checkpoint was taken.
+  void save(Folded_History_Checkpoint<num_folds, true>* checkpoint) const {
+    std::copy(current_values_, current_values_ + num_folds,
+              checkpoint->values);
+  }
+  void restore(const Folded_History_Checkpoint<num_folds, true>& checkpoint) {
+    std::copy(checkpoint.values, checkpoint.values + num_folds,
+              current_values_);
+  }
 
-    // Fold shifted-out bit in.
-    current_value_ ^= current_value_ >> compressed_length_;
+  // The lengths are set by the owner, only the values are saved.
+  void save_state(State_Writer* writer) const {
+    writer->write(current_values_, num_folds);
+  }
+  void load_state(State_Reader* reader) {
+    reader->read(current_values_, num_folds);
+  }
 
-    // Mask out the unused bits.
-    current_value_ &= (1 << compressed_length_) - 1;
+  // Folds the last num_bits bits inserted into the history into every folded
+  // history. num_bits cannot be greater than the shortest compressed length.
+  void update(const Long_History_Register<history_size>& history_register,
+              int num_bits) {
+    update_all<false>(history_register, num_bits);
   }
 
+  // Undoes update() for the num_bits most recent bits of the history. Should
+  // be called before rewinding the history.
   void update_reverse(
-      const Long_History_Register<history_size>& history_register) {
-    // Fold out the most recent GHR bit.
-    current_value_ ^= history_register[0];
-
-    // Fold out the least recent GHR bit.
-    current_value_ ^= history_register[original_length_] << outpoint_;
+      const Long_History_Register<history_size>& history_register,
+      int num_bits) {
+    update_all<true>(history_register, num_bits);
+  }
 
-    // Rotate the low bit around to high bit.
-    current_value_ = ((current_value_ & 1) << (compressed_length_ - 1)) |
-                     (current_value_ >> 1);
+  // update() (or update_reverse() if reverse) with the scalar implementation,
+  // whatever the target. The SIMD implementations must give the same values.
+  template <bool reverse>
+  void update_all_scalar(
+      const Long_History_Register<history_size>& history_register,
+      int num_bits);
 
-    // Mask out the unused bits.
-    current_value_ &= (1 << compressed_length_) - 1;
+ private:
+#if defined(__AVX512F__)
+  static constexpr int simd_lanes_ = 16;
+#elif defined(__AVX2__)
+  static constexpr int simd_lanes_ = 8;
+#else
+  static constexpr int simd_lanes_ = 1;
+#endif
+  static constexpr int padded_num_folds_ =
+      (num_folds + simd_lanes_ - 1) / simd_lanes_ * simd_lanes_;
+
+  // Every older bit moves num_bits positions up (modulo the compressed
+  // length), and the most recent and least recent bits of the history are
+  // folded in at their final positions. The reverse update applies the
+  // inverse transformation.
+  template <bool reverse>
+  void update_all(const Long_History_Register<history_size>& history_register,
+                  int num_bits);
+
+  static uint32_t rotate_left(uint32_t value, int amount,
+                              int compressed_length) {
+    value = (value << amount) | (value >> (compressed_length - amount));
+    return value & ((uint32_t{1} << compressed_length) - 1);
   }
 
- private:
-  int64_t current_value_;
-  int original_length_;
-  int compressed_length_;
-  int outpoint_;
+  alignas(64) int32_t current_values_[padded_num_folds_];
+  alignas(64) int32_t original_lengths_[padded_num_folds_];
+  alignas(64) int32_t compressed_lengths_[padded_num_folds_];
+  alignas(64) int32_t outpoints_[padded_num_folds_];
 };
 
+#if defined(__AVX512F__)
+// GCC 12 warns about the undefined pass-through operands of the AVX-512
+// intrinsics themselves.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+template <int history_size, int num_folds>
+template <bool reverse>
+void Folded_History_Bank<history_size, num_folds>::update_all(
+    const Long_History_Register<history_size>& history_register,
+    int num_bits) {
+  // The buffer is read as 32-bit words so that each lane gathers its own.
+  const void* words = history_register.data();
+  const __m512i head = _mm512_set1_epi32(
+      static_cast<int32_t>(history_register.head_position()));
+  const __m512i position_mask = _mm512_set1_epi32(
+      static_cast<int32_t>(history_register.buffer_access_mask()));
+  const __m512i word_mask = _mm512_set1_epi32(
+      static_cast<int32_t>(history_register.buffer_access_mask() >> 5));
+  const __m512i ones = _mm512_set1_epi32(1);
+  const __m512i thirty_two = _mm512_set1_epi32(32);
+  const __m512i bits_mask = _mm512_set1_epi32((1 << num_bits) - 1);
+  const __m512i shift = _mm512_set1_epi32(num_bits);
+  const __m512i incoming = _mm512_set1_epi32(
+      static_cast<int32_t>(history_register.get_bits(0, num_bits)));
+
+  for (int i = 0; i < padded_num_folds_; i += simd_lanes_) {
+    __m512i compressed_length = _mm512_load_si512(compressed_lengths_ + i);
+    __m512i compressed_mask =
+        _mm512_sub_epi32(_mm512_sllv_epi32(ones, compressed_length), ones);
+    auto rotate = [&](__m512i value, __m512i amount) {
+      __m512i rotated = _mm512_or_si512(
+          _mm512_sllv_epi32(value, amount),
+          _mm512_srlv_epi32(value,
+                            _mm512_sub_epi32(compressed_length, amount)));
+      return _mm512_and_si512(rotated, compressed_mask);
+    };
+
+    __m512i position = _mm512_and_si512(
+        _mm512_add_epi32(head, _mm512_load_si512(original_lengths_ + i)),
+        position_mask);
+    __m512i word = _mm512_srli_epi32(position, 5);
+    __m512i offset = _mm512_and_si512(position, _mm512_set1_epi32(31));
+    __m512i low = _mm512_i32gather_epi32(word, words, 4);
+    __m512i high = _mm512_i32gather_epi32(
+        _mm512_and_si512(_mm512_add_epi32(word, ones), word_mask), words, 4);
+    __m512i outgoing = _mm512_and_si512(
+        _mm512_or_si512(
+            _mm512_srlv_epi32(low, offset),
+            _mm512_sllv_epi32(high, _mm512_sub_epi32(thirty_two, offset))),
+        bits_mask);
+
+    __m512i folded_bits = _mm512_xor_si512(
+        incoming, rotate(outgoing, _mm512_load_si512(outpoints_ + i)));
+    __m512i value = _mm512_load_si512(current_values_ + i);
+    if (reverse) {
+      value = rotate(_mm512_xor_si512(value, folded_bits),
+                     _mm512_sub_epi32(compressed_length, shift));
+    } else {
+      value = _mm512_xor_si512(rotate(value, shift), folded_bits);
+    }
+    _mm512_store_si512(current_values_ + i, value);
+  }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#elif defined(__AVX2__)
+template <int history_size, int num_folds>
+template <bool reverse>
+void Folded_History_Bank<history_size, num_folds>::update_all(
+    const Long_History_Register<history_size>& history_register,
+    int num_bits) {
+  // The buffer is read as 32-bit words so that each lane gathers its own.
+  const int* words = reinterpret_cast<const int*>(history_register.data());
+  const __m256i head = _mm256_set1_epi32(
+      static_cast<int32_t>(history_register.head_position()));
+  const __m256i position_mask = _mm256_set1_epi32(
+      static_cast<int32_t>(history_register.buffer_access_mask()));
+  const __m256i word_mask = _mm256_set1_epi32(
+      static_cast<int32_t>(history_register.buffer_access_mask() >> 5));
+  const __m256i ones = _mm256_set1_epi32(1);
+  const __m256i thirty_two = _mm256_set1_epi32(32);
+  const __m256i bits_mask = _mm256_set1_epi32((1 << num_bits) - 1);
+  const __m256i shift = _mm256_set1_epi32(num_bits);
+  const __m256i incoming = _mm256_set1_epi32(
+      static_cast<int32_t>(history_register.get_bits(0, num_bits)));
+
+  for (int i = 0; i < padded_num_folds_; i += simd_lanes_) {
+    __m256i compressed_length = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(compressed_lengths_ + i));
+    __m256i compressed_mask =
+        _mm256_sub_epi32(_mm256_sllv_epi32(ones, compressed_length), ones);
+    auto rotate = [&](__m256i value, __m256i amount) {
+      __m256i rotated = _mm256_or_si256(
+          _mm256_sllv_epi32(value, amount),
+          _mm256_srlv_epi32(value,
+                            _mm256_sub_epi32(compressed_length, amount)));
+      return _mm256_and_si256(rotated, compressed_mask);
+    };
+
+    __m256i position = _mm256_and_si256(
+        _mm256_add_epi32(head,
+                         _mm256_load_si256(reinterpret_cast<const __m256i*>(
+                             original_lengths_ + i))),
+        position_mask);
+    __m256i word = _mm256_srli_epi32(position, 5);
+    __m256i offset = _mm256_and_si256(position, _mm256_set1_epi32(31));
+    __m256i low = _mm256_i32gather_epi32(words, word, 4);
+    __m256i high = _mm256_i32gather_epi32(
+        words, _mm256_and_si256(_mm256_add_epi32(word, ones), word_mask), 4);
+    __m256i outgoing = _mm256_and_si256(
+        _mm256_or_si256(
+            _mm256_srlv_epi32(low, offset),
+            _mm256_sllv_epi32(high, _mm256_sub_epi32(thirty_two, offset))),
+        bits_mask);
+
+    __m256i folded_bits = _mm256_xor_si256(
+        incoming,
+        rotate(outgoing,
+               _mm256_load_si256(
+                   reinterpret_cast<const __m256i*>(outpoints_ + i))));
+    __m256i value = _mm256_load_si256(
+        reinterpret_cast<const __m256i*>(current_values_ + i));
+    if (reverse) {
+      value = rotate(_mm256_xor_si256(value, folded_bits),
+                     _mm256_sub_epi32(compressed_length, shift));
+    } else {
+      value = _mm256_xor_si256(rotate(value, shift), folded_bits);
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i*>(current_values_ + i), value);
+  }
+}
+#else
+template <int history_size, int num_folds>
+template <bool reverse>
+void Folded_History_Bank<history_size, num_folds>::update_all(
+    const Long_History_Register<history_size>& history_register,
+    int num_bits) {
+  update_all_scalar<reverse>(history_register, num_bits);
+}
+#endif
+
+template <int history_size, int num_folds>
+template <bool reverse>
+void Folded_History_Bank<history_size, num_folds>::update_all_scalar(
+    const Long_History_Register<history_size>& history_register,
+    int num_bits) {
+  uint32_t incoming = history_register.get_bits(0, num_bits);
+  for (int i = 0; i < num_folds; ++i) {
+    assert(num_bits <= compressed_lengths_[i]);
+    uint32_t outgoing =
+        history_register.get_bits(original_lengths_[i], num_bits);
+    uint32_t folded_bits =
+        incoming ^ rotate_left(outgoing, outpoints_[i], compressed_lengths_[i]);
+    uint32_t value = current_values_[i];
+    if (reverse) {
+      value = rotate_left(value ^ folded_bits,
+                          compressed_lengths_[i] - num_bits,
+                          compressed_lengths_[i]);
+    } else {
+      value = rotate_left(value, num_bits, compressed_lengths_[i]) ^
+              folded_bits;
+    }
+    current_values_[i] = value;
+  }
+}
+
 template <class TAGE_CONFIG>
 struct Tage_History_Sizes {
   static constexpr int N = TAGE_CONFIG::NUM_HISTORIES;
@@ -185,9 +519,45 @@ struct Tage_Tables_Enabled {
     arr[8] = false;
     arr[2 * N - 6] = false;
   }
+
+  constexpr int num_enabled() const {
+    int num_tables = 0;
+    for (int i = 1; i <= 2 * N; ++i) {
+      num_tables += arr[i];
+    }
+    return num_tables;
+  }
+
   bool arr[2 * N + 1];
 };
 
+// The enabled tables in increasing order. Only they have an index and a tag
+// in Tage_Prediction_Info, stored at their position in the list (their slot).
+template <class TAGE_CONFIG>
+struct Tage_Enabled_Banks {
+  static constexpr int N = TAGE_CONFIG::NUM_HISTORIES;
+  static constexpr int NUM_BANKS =
+      Tage_Tables_Enabled<TAGE_CONFIG>().num_enabled();
+
+  constexpr Tage_Enabled_Banks() : banks(), slots() {
+    Tage_Tables_Enabled<TAGE_CONFIG> tables_enabled;
+    int num_banks = 0;
+    slots[0] = -1;
+    for (int i = 1; i <= 2 * N; ++i) {
+      if (tables_enabled.arr[i]) {
+        banks[num_banks] = i;
+        slots[i] = num_banks++;
+      } else {
+        slots[i] = -1;
+      }
+    }
+  }
+
+  int banks[NUM_BANKS];
+  // The slot of each table, -1 for the disabled ones and for the bimodal.
+  int slots[2 * N + 1];
+};
+
 template <class TAGE_CONFIG>
 struct Tage_Tag_Bits {
   static constexpr int N = TAGE_CONFIG::NUM_HISTORIES;
@@ -203,6 +573,81 @@ struct Tage_Tag_Bits {
   int arr[N];
 };
 
+// True if table i and table i + 1 are the two ways of a pair laid out by
+// Tage::set_interleaved_indices().
+template <class TAGE_CONFIG>
+constexpr bool is_first_interleaved_tage_way(
+    const Tage_Tables_Enabled<TAGE_CONFIG>& tables_enabled, int i) {
+  return TAGE_CONFIG::INTERLEAVE_2WAY_TABLES && (i & 1) &&
+         i >= TAGE_CONFIG::FIRST_2WAY_TABLE &&
+         i + 1 <= TAGE_CONFIG::LAST_2WAY_TABLE && tables_enabled.arr[i] &&
+         tables_enabled.arr[i + 1] &&
+         (i >= TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE ||
+          i + 1 < TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE);
+}
+
+// The parameters of the index and tag hashes, which only depend on the
+// history of a table (the tables of history j are 2 * j + 1 and 2 * j + 2)
+// or on the table.
+template <class TAGE_CONFIG>
+struct Tage_Index_Params {
+  static constexpr int N = TAGE_CONFIG::NUM_HISTORIES;
+  static constexpr int LOG_ENTRIES = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
+
+  constexpr Tage_Index_Params()
+      : pc_shifts(),
+        path_masks(),
+        path_rotations(),
+        tag_masks(),
+        bank_offsets(),
+        second_interleaved_ways() {
+    Tage_History_Sizes<TAGE_CONFIG> history_sizes;
+    Tage_Tag_Bits<TAGE_CONFIG> tag_bits;
+    Tage_Tables_Enabled<TAGE_CONFIG> tables_enabled;
+    for (int j = 0; j < N; ++j) {
+      int bank = 2 * j + 1;
+      pc_shifts[j] =
+          (LOG_ENTRIES > bank ? LOG_ENTRIES - bank : bank - LOG_ENTRIES) + 1;
+      int max_path_width =
+          std::min(history_sizes.arr[j], TAGE_CONFIG::PATH_HISTORY_WIDTH);
+      path_masks[j] = (1 << max_path_width) - 1;
+      path_rotations[j] = bank < LOG_ENTRIES ? bank : 0;
+      tag_masks[j] = (1 << tag_bits.arr[j]) - 1;
+    }
+
+    // The banks of the enabled tables of each group (short and long
+    // histories) are consecutive, modulo the number of banks of the group,
+    // starting from a bank that depends on the branch.
+    int num_short_history_tables = 0;
+    int num_long_history_tables = 0;
+    for (int i = 1; i <= 2 * N; ++i) {
+      bool is_long_history = i >= TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE;
+      int& num_tables =
+          is_long_history ? num_long_history_tables : num_short_history_tables;
+      int num_banks = is_long_history ? TAGE_CONFIG::LONG_HISTORY_NUM_BANKS
+                                      : TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
+      bank_offsets[i] = num_tables % num_banks;
+      if (is_first_interleaved_tage_way(tables_enabled, i)) {
+        num_tables += 2;
+        second_interleaved_ways[i + 1] = true;
+      } else if (tables_enabled.arr[i] && !second_interleaved_ways[i]) {
+        num_tables += 1;
+      }
+    }
+  }
+
+  // Per history.
+  int pc_shifts[N];
+  int path_masks[N];
+  // The rotation of the path hash, 0 if it is not rotated.
+  int path_rotations[N];
+  int tag_masks[N];
+
+  // Per table.
+  int bank_offsets[2 * N + 1];
+  bool second_interleaved_ways[2 * N + 1];
+};
+
 struct Bimodal_Output {
   bool prediction;
   bool confidence;
@@ -228,13 +673,17 @@ struct Tage_Prediction_Info {
   int hit_bank;
   int alt_bank;
 
-  // Extra information needed for updates.
-  int indices[2 * TAGE_CONFIG::NUM_HISTORIES + 1];
-  int tags[2 * TAGE_CONFIG::NUM_HISTORIES + 1];
+  // Extra information needed for updates. The indices and tags of the
+  // enabled tables, by slot (see Tage_Enabled_Banks).
+  int indices[Tage_Enabled_Banks<TAGE_CONFIG>::NUM_BANKS];
+  int tags[Tage_Enabled_Banks<TAGE_CONFIG>::NUM_BANKS];
   int num_global_history_bits;
   int64_t global_history_head_checkpoint_;
   int64_t path_history_checkpoint;
   int64_t path_history_commit_checkpoint;
+  Folded_History_Checkpoint<3 * TAGE_CONFIG::NUM_HISTORIES,
+                            TAGE_CONFIG::CHECKPOINT_FOLDED_HISTORIES>
+      folded_histories_checkpoint;
 };
 
 template <class TAGE_CONFIG>
@@ -243,6 +692,7 @@ class Tage_Histories {
   Tage_Histories(int max_in_flight_branches)
       : history_register_(3 * max_in_flight_branches) {
     path_history_ = 0;
+    commit_path_history_ = 0;
     intialize_folded_history();
   }
 
@@ -265,19 +715,16 @@ class Tage_Histories {
     prediction_info->path_history_checkpoint = path_history_;
     prediction_info->global_history_head_checkpoint_ =
         history_register_.head_idx();
+    if constexpr (TAGE_CONFIG::CHECKPOINT_FOLDED_HISTORIES) {
+      folded_histories_.save(&prediction_info->folded_histories_checkpoint);
+    }
 
-    for (int i = 0; i < num_bit_inserts; ++i) {
-      history_register_.push_bit(pc_dir_hash & 1);
-      pc_dir_hash >>= 1;
+    history_register_.push_bits(pc_dir_hash, num_bit_inserts);
+    folded_histories_.update(history_register_, num_bit_inserts);
 
+    for (int i = 0; i < num_bit_inserts; ++i) {
       path_history_ = (path_history_ << 1) ^ (path_hash & 127);
       path_hash >>= 1;
-
-      for (int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
-        folded_histories_for_indices_[j].update(history_register_);
-        folded_histories_for_tags_0_[j].update(history_register_);
-        folded_histories_for_tags_1_[j].update(history_register_);
-      }
     }
 
     path_history_ =
@@ -287,23 +734,54 @@ class Tage_Histories {
 
   void intialize_folded_history(void);
 
-  // Hash function for the path history used in creating table indices.
-  int64_t compute_path_hash(int64_t path_history, int max_width, int bank,
-                            int index_size) const;
+  // Values of the folded histories used for the index and the tag of the
+  // tables of history i.
+  int64_t folded_history_for_indices(int i) const {
+    return folded_histories_.get_value(i);
+  }
+  int64_t folded_history_for_tags_0(int i) const {
+    return folded_histories_.get_value(TAGE_CONFIG::NUM_HISTORIES + i);
+  }
+  int64_t folded_history_for_tags_1(int i) const {
+    return folded_histories_.get_value(2 * TAGE_CONFIG::NUM_HISTORIES + i);
+  }
+
+  // Saves and loads the histories. There should be no branches in flight.
+  void save_state(State_Writer* writer) const {
+    history_register_.save_state(writer);
+    folded_histories_.save_state(writer);
+    writer->write(path_history_);
+    writer->write(commit_path_history_);
+  }
+  void load_state(State_Reader* reader) {
+    history_register_.load_state(reader);
+    folded_histories_.load_state(reader);
+    reader->read(&path_history_);
+    reader->read(&commit_path_history_);
+  }
+
+  // Hash function for the path history used in creating the indices of the
+  // tables of history j.
+  template <int j>
+  static int64_t compute_path_hash(int64_t path_history);
 
   // Derived constants
   static constexpr int twice_num_histories_ = 2 * TAGE_CONFIG::NUM_HISTORIES;
+  // Maximum number of bits that can be folded at once into every folded
+  // history (the shortest compressed length).
+  static constexpr int max_folded_bits_per_update_ =
+      std::min({TAGE_CONFIG::LOG_ENTRIES_PER_BANK,
+                TAGE_CONFIG::SHORT_HISTORY_TAG_BITS - 1,
+                TAGE_CONFIG::LONG_HISTORY_TAG_BITS - 1});
   static constexpr Tage_History_Sizes<TAGE_CONFIG> history_sizes_ = {};
   static constexpr Tage_Tag_Bits<TAGE_CONFIG> tag_bits_ = {};
 
   // Predictor State
   Long_History_Register<TAGE_CONFIG::MAX_HISTORY_SIZE> history_register_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>>
-      folded_histories_for_indices_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>>
-      folded_histories_for_tags_0_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>>
-      folded_histories_for_tags_1_;
+  // Folded histories for indices, tags_0 and tags_1, in this order.
+  Folded_History_Bank<TAGE_CONFIG::MAX_HISTORY_SIZE,
+                      3 * TAGE_CONFIG::NUM_HISTORIES>
+      folded_histories_;
 
   int64_t path_history_;
   int64_t commit_path_history_;
@@ -312,9 +790,14 @@ class Tage_Histories {
 template <class TAGE_CONFIG>
 class Tage {
  public:
-  Tage(Random_Number_Generator& random_number_gen, int max_in_flight_branches)
+  // Each of the num_threads hardware threads has its own histories, and they
+  // all share the tables.
+  Tage(Random_Number_Generator& random_number_gen, int max_in_flight_branches,
+       int num_threads = 1)
       : tagged_table_ptrs_(),
-        tage_histories_(max_in_flight_branches),
+        thread_histories_(num_threads,
+                          Tage_Histories<TAGE_CONFIG>(max_in_flight_branches)),
+        tage_histories_(&thread_histories_[0]),
         low_history_tagged_table_(),
         high_history_tagged_table_(),
         alt_selector_table_(),
@@ -323,10 +806,13 @@ class Tage {
     intialize_predictor_state();
   }
 
-  void get_prediction(
-      uint64_t br_pc,
-      Tage_Prediction_Info<TAGE_CONFIG>* prediction_info) const {
-    fill_table_indices_tags(br_pc, prediction_info);
+  // If indices_filled, the indices and tags computed by prefetch() are used.
+  void get_prediction(uint64_t br_pc,
+                      Tage_Prediction_Info<TAGE_CONFIG>* prediction_info,
+                      bool indices_filled = false) const {
+    if (!indices_filled) {
+      fill_table_indices_tags(br_pc, prediction_info);
+    }
     auto& indices = prediction_info->indices;
     auto& tags = prediction_info->tags;
 
@@ -350,15 +836,13 @@ class Tage {
     prediction_info->alt_bank = matched_banks.alt_bank;
     if (prediction_info->hit_bank != 0) {
       int8_t longest_match_counter =
-          tagged_table_ptrs_[prediction_info->hit_bank]
-                            [indices[prediction_info->hit_bank]]
-                                .pred_counter.get();
+          tagged_entry(prediction_info->hit_bank, *prediction_info)
+              .pred_counter();
       prediction_info->longest_match_prediction = longest_match_counter >= 0;
       if (prediction_info->alt_bank != 0) {
         int8_t alt_match_counter =
-            tagged_table_ptrs_[prediction_info->alt_bank]
-                              [indices[prediction_info->alt_bank]]
-                                  .pred_counter.get();
+            tagged_entry(prediction_info->alt_bank, *prediction_info)
+                .pred_counter();
         prediction_info->alt_prediction = alt_match_counter >= 0;
         prediction_info->alt_confidence =
             std::abs(2 * alt_match_counter + 1) > 1;
@@ -392,8 +876,8 @@ class Tage {
       uint64_t br_pc, uint64_t br_target, Branch_Type br_type,
       bool final_prediction,
       Tage_Prediction_Info<TAGE_CONFIG>* prediction_info) {
-    tage_histories_.push_into_history(br_pc, br_target, br_type,
-                                      final_prediction, prediction_info);
+    tage_histories_->push_into_history(br_pc, br_target, br_type,
+                                       final_prediction, prediction_info);
   }
 
   void commit_state(uint64_t br_pc, bool resolve_dir,
@@ -402,7 +886,19 @@ class Tage {
     const int* indices = prediction_info.indices;
     const int* tags = prediction_info.tags;
 
-    tage_histories_.commit_path_history_ =
+    if (TAGE_CONFIG::COLLECT_STATISTICS) {
+      bool mispredicted = prediction_info.prediction != resolve_dir;
+      statistics_.provider_hits[prediction_info.hit_bank] += 1;
+      statistics_.provider_mispredictions[prediction_info.hit_bank] +=
+          mispredicted;
+      if (prediction_info.prediction !=
+          prediction_info.longest_match_prediction) {
+        statistics_.alt_predictions += 1;
+        statistics_.alt_mispredictions += mispredicted;
+      }
+    }
+
+    tage_histories_->commit_path_history_ =
         prediction_info.path_history_commit_checkpoint;
 
     bool allocate_new_entry =
@@ -421,9 +917,8 @@ class Tage {
       // counter is
       // weak.
       Tagged_Entry& matched_entry =
-          tagged_table_ptrs_[prediction_info.hit_bank]
-                            [indices[prediction_info.hit_bank]];
-      if (std::abs(2 * matched_entry.pred_counter.get() + 1) <= 1) {
+          tagged_entry(prediction_info.hit_bank, prediction_info);
+      if (std::abs(2 * matched_entry.pred_counter() + 1) <= 1) {
         if (prediction_info.longest_match_prediction == resolve_dir) {
           // If it was delivering the correct prediction, no need to
           // allocate a
@@ -442,6 +937,9 @@ class Tage {
 
           alt_selector_table_[alt_selector_table_index].update(
               prediction_info.alt_prediction == resolve_dir);
+          if (TAGE_CONFIG::COLLECT_STATISTICS) {
+            statistics_.alt_selector_updates += 1;
+          }
         }
       }
     }
@@ -471,12 +969,13 @@ class Tage {
            allocation_bank += 2) {
         int i = allocation_bank + 1;  // REVISIT: is i needed?
         bool done = false;
-        if (tables_enabled_.arr[i]) {
-          Tagged_Entry& bank_entry = tagged_table_ptrs_[i][indices[i]];
-          if (bank_entry.useful.get() == 0) {
-            if (std::abs(2 * bank_entry.pred_counter.get() + 1) <= 3) {
-              bank_entry.tag = tags[i];
-              bank_entry.pred_counter.set(resolve_dir ? 0 : -1);
+        int slot = enabled_banks_.slots[i];
+        if (slot >= 0) {
+          Tagged_Entry& bank_entry = tagged_table_ptrs_[i][indices[slot]];
+          if (bank_entry.useful() == 0) {
+            if (std::abs(2 * bank_entry.pred_counter() + 1) <= 3) {
+              bank_entry.set_tag(tags[slot]);
+              bank_entry.set_pred_counter(resolve_dir ? 0 : -1);
               num_allocated += 1;
               if (num_extra_entries_to_allocate <= 0) {
                 break;
@@ -485,10 +984,10 @@ class Tage {
               done = true;
               num_extra_entries_to_allocate -= 1;
             } else {
-              if (bank_entry.pred_counter.get() > 0) {
-                bank_entry.pred_counter.decrement();
+              if (bank_entry.pred_counter() > 0) {
+                bank_entry.decrement_pred_counter();
               } else {
-                bank_entry.pred_counter.increment();
+                bank_entry.increment_pred_counter();
               }
             }
           } else {
@@ -501,13 +1000,14 @@ class Tage {
         // code should be abstracted in a function.
         if (!done) {
           i = (allocation_bank ^ 1) + 1;
-          if (tables_enabled_.arr[i]) {
-            Tagged_Entry& bank_entry = tagged_table_ptrs_[i][indices[i]];
-
-            if (bank_entry.useful.get() == 0) {
-              if (std::abs(2 * bank_entry.pred_counter.get() + 1) <= 3) {
-                bank_entry.tag = tags[i];
-                bank_entry.pred_counter.set(resolve_dir ? 0 : -1);
+          slot = enabled_banks_.slots[i];
+          if (slot >= 0) {
+            Tagged_Entry& bank_entry = tagged_table_ptrs_[i][indices[slot]];
+
+            if (bank_entry.useful() == 0) {
+              if (std::abs(2 * bank_entry.pred_counter() + 1) <= 3) {
+                bank_entry.set_tag(tags[slot]);
+                bank_entry.set_pred_counter(resolve_dir ? 0 : -1);
                 num_allocated += 1;
                 if (num_extra_entries_to_allocate <= 0) {
                   break;
@@ -515,10 +1015,10 @@ class Tage {
                 allocation_bank += 2;
                 num_extra_entries_to_allocate -= 1;
               } else {
-                if (bank_entry.pred_counter.get() > 0) {
-                  bank_entry.pred_counter.decrement();
+                if (bank_entry.pred_counter() > 0) {
+                  bank_entry.decrement_pred_counter();
                 } else {
-                  bank_entry.pred_counter.increment();
+                  bank_entry.increment_pred_counter();
                 }
               }
             } else {
@@ -528,6 +1028,12 @@ class Tage {
         }
       }
 
+      if (TAGE_CONFIG::COLLECT_STATISTICS) {
+        statistics_.allocation_attempts += 1;
+        statistics_.allocated_entries += num_allocated;
+        statistics_.failed_allocations += num_allocated == 0;
+      }
+
       tick_ += (tick_penalty - 2 * num_allocated);
       tick_ = std::max(tick_, 0);
       if (tick_ >= TAGE_CONFIG::TICKS_UNTIL_USEFUL_SHIFT) {
@@ -538,42 +1044,42 @@ class Tage {
                                TAGE_CONFIG::LONG_HISTORY_NUM_BANKS *
                                    (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK));
         tick_ = 0;
+        if (TAGE_CONFIG::COLLECT_STATISTICS) {
+          statistics_.useful_bit_resets += 1;
+        }
       }
     }
 
     // Update prediction
     if (prediction_info.hit_bank > 0) {
       Tagged_Entry& matched_entry =
-          tagged_table_ptrs_[prediction_info.hit_bank]
-                            [indices[prediction_info.hit_bank]];
-      if (std::abs(2 * matched_entry.pred_counter.get() + 1) == 1) {
+          tagged_entry(prediction_info.hit_bank, prediction_info);
+      if (std::abs(2 * matched_entry.pred_counter() + 1) == 1) {
         if (prediction_info.longest_match_prediction !=
             resolve_dir) {  // acts as a protection
           if (prediction_info.alt_bank > 0) {
             Tagged_Entry& alt_matched_entry =
-                tagged_table_ptrs_[prediction_info.alt_bank]
-                                  [indices[prediction_info.alt_bank]];
-            alt_matched_entry.pred_counter.update(resolve_dir);
+                tagged_entry(prediction_info.alt_bank, prediction_info);
+            alt_matched_entry.update_pred_counter(resolve_dir);
           } else {
             update_bimodal(br_pc, resolve_dir);
           }
         }
       }
 
-      matched_entry.pred_counter.update(resolve_dir);
+      matched_entry.update_pred_counter(resolve_dir);
       // sign changes: no way it can have been useful
-      if (std::abs(2 * matched_entry.pred_counter.get() + 1) == 1) {
-        matched_entry.useful.set(0);
+      if (std::abs(2 * matched_entry.pred_counter() + 1) == 1) {
+        matched_entry.set_useful(0);
       }
       if (prediction_info.alt_prediction == resolve_dir &&
           prediction_info.alt_bank > 0) {
         Tagged_Entry& alt_matched_entry =
-            tagged_table_ptrs_[prediction_info.alt_bank]
-                              [indices[prediction_info.alt_bank]];
-        if (std::abs(2 * alt_matched_entry.pred_counter.get() + 1) == 7 &&
-            matched_entry.useful.get() == 1 &&
+            tagged_entry(prediction_info.alt_bank, prediction_info);
+        if (std::abs(2 * alt_matched_entry.pred_counter() + 1) == 7 &&
+            matched_entry.useful() == 1 &&
             prediction_info.longest_match_prediction == resolve_dir) {
-          matched_entry.useful.set(0);
+          matched_entry.set_useful(0);
         }
       }
     } else {
@@ -584,15 +1090,14 @@ class Tage {
             prediction_info.alt_prediction &&
         prediction_info.longest_match_prediction == resolve_dir) {
       Tagged_Entry& matched_entry =
-          tagged_table_ptrs_[prediction_info.hit_bank]
-                            [indices[prediction_info.hit_bank]];
-      matched_entry.useful.increment();
+          tagged_entry(prediction_info.hit_bank, prediction_info);
+      matched_entry.increment_useful();
     }
   }
 
   void commit_state_at_retire(
       const Tage_Prediction_Info<TAGE_CONFIG>& prediction_info) {
-    tage_histories_.history_register_.retire(
+    tage_histories_->history_register_.retire(
         prediction_info.num_global_history_bits);
   }
 
@@ -600,41 +1105,172 @@ class Tage {
       const Tage_Prediction_Info<TAGE_CONFIG>& prediction_info) {
     int64_t num_flushed_bits =
         (prediction_info.global_history_head_checkpoint_ -
-         tage_histories_.history_register_.head_idx());
-    for (int i = 0; i < num_flushed_bits; ++i) {
-      for (int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
-        tage_histories_.folded_histories_for_indices_[j].update_reverse(
-            tage_histories_.history_register_);
-        tage_histories_.folded_histories_for_tags_0_[j].update_reverse(
-            tage_histories_.history_register_);
-        tage_histories_.folded_histories_for_tags_1_[j].update_reverse(
-            tage_histories_.history_register_);
+         tage_histories_->history_register_.head_idx());
+    if (TAGE_CONFIG::COLLECT_STATISTICS) {
+      uint64_t num_bits = std::max<int64_t>(num_flushed_bits, 0);
+      statistics_.recoveries += 1;
+      statistics_.recovered_history_bits += num_bits;
+      statistics_.recovered_history_bits_histogram.add(num_bits);
+    }
+    if constexpr (TAGE_CONFIG::CHECKPOINT_FOLDED_HISTORIES) {
+      // The checkpoint holds the folded histories from before the branch
+      // inserted its bits.
+      if (num_flushed_bits > 0) {
+        tage_histories_->folded_histories_.restore(
+            prediction_info.folded_histories_checkpoint);
+        tage_histories_->history_register_.rewind(num_flushed_bits);
+      }
+    } else {
+      while (num_flushed_bits > 0) {
+        int num_bits = static_cast<int>(std::min<int64_t>(
+            num_flushed_bits,
+            Tage_Histories<TAGE_CONFIG>::max_folded_bits_per_update_));
+        tage_histories_->folded_histories_.update_reverse(
+            tage_histories_->history_register_, num_bits);
+        tage_histories_->history_register_.rewind(num_bits);
+        num_flushed_bits -= num_bits;
       }
-      tage_histories_.history_register_.rewind(1);
     }
-    tage_histories_.path_history_ = prediction_info.path_history_checkpoint;
+    tage_histories_->path_history_ = prediction_info.path_history_checkpoint;
   }
 
   void local_recover_speculative_state(
       const Tage_Prediction_Info<TAGE_CONFIG>& prediction_info) {}
 
+  // Computes the indices and tags that get_prediction() would use for br_pc
+  // with the current speculative state, and prefetches the table entries they
+  // point to.
+  void prefetch(uint64_t br_pc,
+                Tage_Prediction_Info<TAGE_CONFIG>* prediction_info) const {
+    fill_table_indices_tags(br_pc, prediction_info);
+    for (int slot = 0; slot < Tage_Enabled_Banks<TAGE_CONFIG>::NUM_BANKS;
+         ++slot) {
+      __builtin_prefetch(&tagged_table_ptrs_[enabled_banks_.banks[slot]]
+                                            [prediction_info->indices[slot]]);
+    }
+    __builtin_prefetch(&bimodal_table_[get_bimodal_index(br_pc)]);
+  }
+
   static void build_empty_prediction(
       Tage_Prediction_Info<TAGE_CONFIG>* prediction_info) {
     *prediction_info = {};
   }
 
+  // Number of different cache lines of the tagged tables read by a
+  // prediction that used the indices in prediction_info.
+  int num_tagged_cache_lines(
+      const Tage_Prediction_Info<TAGE_CONFIG>& prediction_info) const;
+
+  // Saves and loads the tables and the committed histories. There should be
+  // no branches in flight. The histories saved are those of the active
+  // thread, and the loaded ones replace those of every thread.
+  void save_state(State_Writer* writer) const;
+  void load_state(State_Reader* reader);
+
+  // Makes the histories of thread_id the ones that the rest of the functions
+  // read and update, and the ones the random number generator hashes.
+  void set_active_thread(int thread_id) {
+    assert(0 <= thread_id &&
+           thread_id < static_cast<int>(thread_histories_.size()));
+    tage_histories_ = &thread_histories_[thread_id];
+    random_number_gen_.phist_ptr_ = &tage_histories_->commit_path_history_;
+    random_number_gen_.ptghist_ptr_ =
+        &tage_histories_->history_register_.commit_head_idx();
+  }
+
+  // Adds the parameters of TAGE_CONFIG that affect the saved state.
+  static void fingerprint_config(Config_Fingerprint* fingerprint);
+
+  // Appends the counters collected since the construction or the last
+  // reset_statistics(), under "tage/". Does nothing unless
+  // TAGE_CONFIG::COLLECT_STATISTICS.
+  void append_statistics(std::vector<Statistic>* statistics) const;
+  void reset_statistics() { statistics_ = {}; }
+
  private:
   struct Bimodal_Entry {
     int8_t hysteresis = 1;
     int8_t prediction = 0;
   };
 
-  struct Tagged_Entry {
-    Saturating_Counter<TAGE_CONFIG::PRED_COUNTER_WIDTH, true> pred_counter;
-    Saturating_Counter<TAGE_CONFIG::USEFUL_BITS, false> useful;
-    int tag = 0;
+  // The tag, the prediction counter (signed) and the useful counter
+  // (unsigned) of an entry, packed from the least significant bit in the
+  // smallest unsigned integer that holds them. The counters saturate like a
+  // Saturating_Counter of the same width.
+  class Tagged_Entry {
+   public:
+    int tag() const { return get_field(tag_shift_, tag_width_); }
+    void set_tag(int tag) { set_field(tag_shift_, tag_width_, tag); }
+
+    int pred_counter() const {
+      int value = get_field(pred_counter_shift_, pred_counter_width_);
+      return value > pred_counter_max_ ? value - (1 << pred_counter_width_)
+                                       : value;
+    }
+    void set_pred_counter(int value) {
+      assert(pred_counter_min_ <= value && value <= pred_counter_max_);
+      set_field(pred_counter_shift_, pred_counter_width_, value);
+    }
+    void increment_pred_counter() {
+      int value = pred_counter();
+      if (value < pred_counter_max_) {
+        set_pred_counter(value + 1);
+      }
+    }
+    void decrement_pred_counter() {
+      int value = pred_counter();
+      if (value > pred_counter_min_) {
+        set_pred_counter(value - 1);
+      }
+    }
+    void update_pred_counter(bool condition) {
+      if (condition) {
+        increment_pred_counter();
+      } else {
+        decrement_pred_counter();
+      }
+    }
+
+    int useful() const { return get_field(useful_shift_, useful_width_); }
+    void set_useful(int value) {
+      assert(0 <= value && value <= useful_max_);
+      set_field(useful_shift_, useful_width_, value);
+    }
+    void increment_useful() {
+      int value = useful();
+      if (value < useful_max_) {
+        set_useful(value + 1);
+      }
+    }
+
+   private:
+    static constexpr int tag_width_ =
+        std::max(TAGE_CONFIG::SHORT_HISTORY_TAG_BITS,
+                 TAGE_CONFIG::LONG_HISTORY_TAG_BITS);
+    static constexpr int pred_counter_width_ = TAGE_CONFIG::PRED_COUNTER_WIDTH;
+    static constexpr int useful_width_ = TAGE_CONFIG::USEFUL_BITS;
+    static constexpr int tag_shift_ = 0;
+    static constexpr int pred_counter_shift_ = tag_shift_ + tag_width_;
+    static constexpr int useful_shift_ =
+        pred_counter_shift_ + pred_counter_width_;
+    static constexpr int pred_counter_max_ =
+        (1 << (pred_counter_width_ - 1)) - 1;
+    static constexpr int pred_counter_min_ = -(1 << (pred_counter_width_ - 1));
+    static constexpr int useful_max_ = (1 << useful_width_) - 1;
+
+    using Storage_Type = typename Smallest_Uint_Type<useful_shift_ +
+                                                     useful_width_>::type;
+
+    int get_field(int shift, int width) const {
+      return (bits_ >> shift) & ((1 << width) - 1);
+    }
+    void set_field(int shift, int width, int value) {
+      Storage_Type mask = ((1 << width) - 1) << shift;
+      bits_ = (bits_ & ~mask) |
+              ((static_cast<unsigned>(value) << shift) & mask);
+    }
 
-    Tagged_Entry() : pred_counter(0), useful(0) {}
+    Storage_Type bits_ = 0;
   };
 
   void initialize_tag_bits(void);
@@ -645,31 +1281,85 @@ class Tage {
   void fill_table_indices_tags(
       uint64_t br_pc, Tage_Prediction_Info<TAGE_CONFIG>* tage_output) const;
 
+  // The steps of fill_table_indices_tags() for the tables of each history
+  // and for each enabled table, expanded at compile time.
+  template <int... histories>
+  void fill_indices_tags(uint64_t br_pc,
+                         Tage_Prediction_Info<TAGE_CONFIG>* output,
+                         std::integer_sequence<int, histories...>) const {
+    (fill_history_indices_tags<histories>(br_pc, output), ...);
+  }
+  template <int... slots>
+  static void add_bank_bits(int short_history_bank, int long_history_bank,
+                            Tage_Prediction_Info<TAGE_CONFIG>* output,
+                            std::integer_sequence<int, slots...>) {
+    (add_table_bank_bits<enabled_banks_.banks[slots]>(
+         short_history_bank, long_history_bank, output),
+     ...);
+  }
+  template <int j>
+  void fill_history_indices_tags(
+      uint64_t br_pc, Tage_Prediction_Info<TAGE_CONFIG>* output) const;
+  template <int i>
+  static void add_table_bank_bits(int short_history_bank,
+                                  int long_history_bank,
+                                  Tage_Prediction_Info<TAGE_CONFIG>* output);
+
+  int get_bimodal_index(uint64_t br_pc) const {
+    return (br_pc ^ (br_pc >> 2)) &
+           ((1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE) - 1);
+  }
+
   // Get the prediction and confidence of the bimodal table.
   Bimodal_Output get_bimodal_prediction_confidence(uint64_t br_pc) const;
 
   void update_bimodal(uint64_t br_pc, bool resolve_dir);
 
   // Get the banks IDs of matching tables with longest histories.
-  // A bank of 0 means a match was not found.
+  // A bank of 0 means a match was not found. Gathering the tags of all the
+  // tables with AVX2 or AVX-512 was measured no faster in get_prediction().
   Matched_Table_Banks get_two_longest_matching_tables(int indices[],
                                                       int tags[]) const;
 
   void shift_tage_useful_bits(Tagged_Entry* table, int size);
 
+  // True if table i and table i + 1 are the two ways of a pair laid out by
+  // set_interleaved_indices().
+  static constexpr bool is_first_interleaved_way(int i) {
+    return is_first_interleaved_tage_way(tables_enabled_, i);
+  }
+
+  // The entry of the enabled table bank that prediction_info points to.
+  Tagged_Entry& tagged_entry(
+      int bank,
+      const Tage_Prediction_Info<TAGE_CONFIG>& prediction_info) const {
+    int slot = enabled_banks_.slots[bank];
+    return tagged_table_ptrs_[bank][prediction_info.indices[slot]];
+  }
+
+  // Given the set of an interleaved pair in indices[0] and the bank assigned
+  // to its first way, writes the indices of both ways.
+  static void set_interleaved_indices(int first_bank, int num_banks,
+                                      int* indices);
+
   // Derived constants
   static constexpr Tage_Tables_Enabled<TAGE_CONFIG> tables_enabled_ = {};
+  static constexpr Tage_Enabled_Banks<TAGE_CONFIG> enabled_banks_ = {};
+  static constexpr Tage_Index_Params<TAGE_CONFIG> index_params_ = {};
 
   Tagged_Entry*
       tagged_table_ptrs_[Tage_Histories<TAGE_CONFIG>::twice_num_histories_ + 1];
 
   // Predictor State
-  Tage_Histories<TAGE_CONFIG> tage_histories_;
+  std::vector<Tage_Histories<TAGE_CONFIG>> thread_histories_;
+  // The histories of the active thread.
+  Tage_Histories<TAGE_CONFIG>* tage_histories_;
   Bimodal_Entry bimodal_table_[1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE];
-  Tagged_Entry
+  // Aligned so that the two ways of an interleaved set share a cache line.
+  alignas(64) Tagged_Entry
       low_history_tagged_table_[TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS *
                                 (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK)];
-  Tagged_Entry
+  alignas(64) Tagged_Entry
       high_history_tagged_table_[TAGE_CONFIG::LONG_HISTORY_NUM_BANKS *
                                  (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK)];
 
@@ -678,6 +1368,32 @@ class Tage {
   int tick_;  // for resetting the useful bits
 
   Random_Number_Generator& random_number_gen_;
+
+  // Counters of committed branches and of recoveries, only updated if
+  // TAGE_CONFIG::COLLECT_STATISTICS.
+  struct Statistics {
+    // Indexed by the provider bank, 0 being the bimodal table.
+    int64_t
+        provider_hits[Tage_Histories<TAGE_CONFIG>::twice_num_histories_ + 1] =
+            {};
+    int64_t provider_mispredictions
+        [Tage_Histories<TAGE_CONFIG>::twice_num_histories_ + 1] = {};
+    // Predictions where the alternate prediction was chosen over a different
+    // longest match prediction.
+    int64_t alt_predictions = 0;
+    int64_t alt_mispredictions = 0;
+    int64_t alt_selector_updates = 0;
+    // Mispredictions that tried to allocate entries, the entries allocated,
+    // and the attempts that found no entry to replace.
+    int64_t allocation_attempts = 0;
+    int64_t allocated_entries = 0;
+    int64_t failed_allocations = 0;
+    int64_t useful_bit_resets = 0;
+    int64_t recoveries = 0;
+    int64_t recovered_history_bits = 0;
+    Log2_Histogram<16> recovered_history_bits_histogram;
+  };
+  Statistics statistics_;
 };
 
 template <class TAGE_CONFIG>
@@ -687,6 +1403,9 @@ constexpr Tage_History_Sizes<TAGE_CONFIG>
 template <class TAGE_CONFIG>
 constexpr Tage_Tables_Enabled<TAGE_CONFIG> Tage<TAGE_CONFIG>::tables_enabled_;
 
+template <class TAGE_CONFIG>
+constexpr Tage_Enabled_Banks<TAGE_CONFIG> Tage<TAGE_CONFIG>::enabled_banks_;
+
 template <class TAGE_CONFIG>
 constexpr Tage_Tag_Bits<TAGE_CONFIG> Tage_Histories<TAGE_CONFIG>::tag_bits_;
 
@@ -703,44 +1422,38 @@ void Tage<TAGE_CONFIG>::initialize_table_sizes(void) {
 
 template <class TAGE_CONFIG>
 void Tage_Histories<TAGE_CONFIG>::intialize_folded_history(void) {
-  // insert dummy entries for the zeroth entry of the vector
   for (int i = 0; i < TAGE_CONFIG::NUM_HISTORIES; i++) {
-    // For some reason I cannot pass LOG_ENTRIES_PER_BANK to emplace_bank()
-    // directly (gcc complains that variable is undefined), do not know why.
-    // REVISIT: since I got rid of LOG_ENTRIES_PER_BANK as a constant, this
-    // should be fine now.
-    const int LOG_ENTRIES_PER_BANK2 = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
-    folded_histories_for_indices_.emplace_back(history_sizes_.arr[i],
-                                               LOG_ENTRIES_PER_BANK2);
-    folded_histories_for_tags_0_.emplace_back(history_sizes_.arr[i],
-                                              tag_bits_.arr[i]);
-    folded_histories_for_tags_1_.emplace_back(history_sizes_.arr[i],
-                                              tag_bits_.arr[i] - 1);
+    folded_histories_.set_fold(i, history_sizes_.arr[i],
+                               TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
+    folded_histories_.set_fold(TAGE_CONFIG::NUM_HISTORIES + i,
+                               history_sizes_.arr[i], tag_bits_.arr[i]);
+    folded_histories_.set_fold(2 * TAGE_CONFIG::NUM_HISTORIES + i,
+                               history_sizes_.arr[i], tag_bits_.arr[i] - 1);
   }
 }
 
 template <class TAGE_CONFIG>
 void Tage<TAGE_CONFIG>::intialize_predictor_state(void) {
   tick_ = 0;
-  random_number_gen_.phist_ptr_ = &tage_histories_.commit_path_history_;
-  random_number_gen_.ptghist_ptr_ =
-      &tage_histories_.history_register_.commit_head_idx();
+  set_active_thread(0);
 }
 
 template <class TAGE_CONFIG>
-int64_t Tage_Histories<TAGE_CONFIG>::compute_path_hash(int64_t path_history,
-                                                       int max_width, int bank,
-                                                       int index_size) const {
+template <int j>
+int64_t Tage_Histories<TAGE_CONFIG>::compute_path_hash(int64_t path_history) {
+  constexpr Tage_Index_Params<TAGE_CONFIG> params = {};
+  constexpr int index_size = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
+  constexpr int bank = params.path_rotations[j];
   int64_t temp1, temp2;
 
   // truncate path history to index size.
-  path_history = (path_history & ((1 << max_width) - 1));
+  path_history = (path_history & params.path_masks[j]);
   temp1 = (path_history & ((1 << index_size) - 1));
 
   // Take high part of path history and left rotate it by "bank" ammount
   // this is just to generate a unique hash for each bank
   temp2 = (path_history >> index_size);
-  if (bank < index_size) {
+  if constexpr (bank != 0) {
     temp2 = ((temp2 << bank) & ((1 << index_size) - 1)) +
             (temp2 >> (index_size - bank));
   }
@@ -749,7 +1462,7 @@ int64_t Tage_Histories<TAGE_CONFIG>::compute_path_hash(int64_t path_history,
   path_history = temp1 ^ temp2;
 
   // left rotate that chunk by "bank"
-  if (bank < index_size) {
+  if constexpr (bank != 0) {
     path_history = ((path_history << bank) & ((1 << index_size) - 1)) +
                    (path_history >> (index_size - bank));
   }
@@ -760,77 +1473,132 @@ template <class TAGE_CONFIG>
 void Tage<TAGE_CONFIG>::fill_table_indices_tags(
     uint64_t br_pc, Tage_Prediction_Info<TAGE_CONFIG>* output) const {
   // Generate tags and indices, ignore bank bits for now.
-  for (int i = 1; i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_;
-       i += 2) {
-    if (tables_enabled_.arr[i] || tables_enabled_.arr[i + 1]) {
-      int max_path_width =
-          (tage_histories_.history_sizes_.arr[(i - 1) / 2] >
-           TAGE_CONFIG::PATH_HISTORY_WIDTH)
-              ? TAGE_CONFIG::PATH_HISTORY_WIDTH
-              : tage_histories_.history_sizes_.arr[(i - 1) / 2];
-      int64_t path_hash = tage_histories_.compute_path_hash(
-          tage_histories_.path_history_, max_path_width, i,
-          TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
-      int64_t index = br_pc;
-      index ^= br_pc >> (std::abs(TAGE_CONFIG::LOG_ENTRIES_PER_BANK - i) + 1);
-      index ^= tage_histories_.folded_histories_for_indices_[(i - 1) / 2]
-                   .get_value();
-      index ^= path_hash;
-      output->indices[i] =
-          index & ((1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) - 1);
-
-      int64_t tag = br_pc;
-      tag ^=
-          tage_histories_.folded_histories_for_tags_0_[(i - 1) / 2].get_value();
-      tag ^=
-          tage_histories_.folded_histories_for_tags_1_[(i - 1) / 2].get_value()
-          << 1;
-      output->tags[i] =
-          tag & ((1 << tage_histories_.tag_bits_.arr[(i - 1) / 2]) - 1);
-
-      output->tags[i + 1] = output->tags[i];
-      output->indices[i + 1] =
-          output->indices[i] ^
-          (output->tags[i] & ((1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) - 1));
-    }
-  }
-
-  // Now add bank bits to the indices of high history tables.
-  int temp = (br_pc ^
-              (tage_histories_.path_history_ &
-               ((int64_t(1)
-                 << tage_histories_.history_sizes_
-                        .arr[(TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1) / 2]) -
-                1))) %
-             TAGE_CONFIG::LONG_HISTORY_NUM_BANKS;
-  for (int i = TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE;
-       i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_; ++i) {
-    if (tables_enabled_.arr[i]) {
-      output->indices[i] += (temp << TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
-      temp++;
-      temp = temp % TAGE_CONFIG::LONG_HISTORY_NUM_BANKS;
+  fill_indices_tags(
+      br_pc, output,
+      std::make_integer_sequence<int, TAGE_CONFIG::NUM_HISTORIES>());
+
+  // Now add bank bits to the indices.
+  constexpr int64_t long_history_path_mask =
+      (int64_t(1)
+       << Tage_Histories<TAGE_CONFIG>::history_sizes_
+              .arr[(TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1) / 2]) -
+      1;
+  int long_history_bank =
+      (br_pc ^ (tage_histories_->path_history_ & long_history_path_mask)) %
+      TAGE_CONFIG::LONG_HISTORY_NUM_BANKS;
+  int short_history_bank =
+      (br_pc ^
+       (tage_histories_->path_history_ &
+        ((1 << Tage_Histories<TAGE_CONFIG>::history_sizes_.arr[0]) - 1))) %
+      TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
+  add_bank_bits(
+      short_history_bank, long_history_bank, output,
+      std::make_integer_sequence<int,
+                                 Tage_Enabled_Banks<TAGE_CONFIG>::NUM_BANKS>());
+}
+
+template <class TAGE_CONFIG>
+template <int j>
+void Tage<TAGE_CONFIG>::fill_history_indices_tags(
+    uint64_t br_pc, Tage_Prediction_Info<TAGE_CONFIG>* output) const {
+  constexpr int i = 2 * j + 1;
+  constexpr int first_slot = enabled_banks_.slots[i];
+  constexpr int second_slot = enabled_banks_.slots[i + 1];
+  if constexpr (first_slot < 0 && second_slot < 0) {
+    return;
+  }
+  constexpr int index_mask = (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) - 1;
+  int64_t path_hash =
+      Tage_Histories<TAGE_CONFIG>::template compute_path_hash<j>(
+          tage_histories_->path_history_);
+  int64_t index = br_pc;
+  index ^= br_pc >> index_params_.pc_shifts[j];
+  index ^= tage_histories_->folded_history_for_indices(j);
+  index ^= path_hash;
+  int first_index = index & index_mask;
+
+  int64_t tag = br_pc;
+  tag ^= tage_histories_->folded_history_for_tags_0(j);
+  tag ^= tage_histories_->folded_history_for_tags_1(j) << 1;
+  int masked_tag = tag & index_params_.tag_masks[j];
+
+  if constexpr (first_slot >= 0) {
+    output->indices[first_slot] = first_index;
+    output->tags[first_slot] = masked_tag;
+  }
+  if constexpr (second_slot >= 0) {
+    if constexpr (is_first_interleaved_way(i)) {
+      // Both ways of an interleaved pair use the same set, see
+      // set_interleaved_indices().
+      output->indices[second_slot] = first_index;
+    } else {
+      output->indices[second_slot] = first_index ^ (masked_tag & index_mask);
     }
+    output->tags[second_slot] = masked_tag;
   }
+}
 
-  // Now add bank bits to the indices of low history tables.
-  temp = (br_pc ^ (tage_histories_.path_history_ &
-                   ((1 << tage_histories_.history_sizes_.arr[0]) - 1))) %
-         TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
-  for (int i = 1; i <= TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1; ++i) {
-    if (tables_enabled_.arr[i]) {
-      output->indices[i] += (temp << TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
-      temp++;
-      temp = temp % TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
-    }
+template <class TAGE_CONFIG>
+template <int i>
+void Tage<TAGE_CONFIG>::add_table_bank_bits(
+    int short_history_bank, int long_history_bank,
+    Tage_Prediction_Info<TAGE_CONFIG>* output) {
+  constexpr bool is_long_history = i >= TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE;
+  constexpr int num_banks = is_long_history
+                                ? TAGE_CONFIG::LONG_HISTORY_NUM_BANKS
+                                : TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
+  constexpr int slot = enabled_banks_.slots[i];
+  if constexpr (index_params_.second_interleaved_ways[i]) {
+    return;
+  }
+  // Both banks are below num_banks, and so is the offset.
+  int bank = (is_long_history ? long_history_bank : short_history_bank) +
+             index_params_.bank_offsets[i];
+  bank -= bank >= num_banks ? num_banks : 0;
+  if constexpr (is_first_interleaved_way(i)) {
+    // The second way is enabled too, so it is in the next slot.
+    set_interleaved_indices(bank, num_banks, &output->indices[slot]);
+  } else {
+    output->indices[slot] += bank << TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
+  }
+}
+
+template <class TAGE_CONFIG>
+void Tage<TAGE_CONFIG>::set_interleaved_indices(int first_bank, int num_banks,
+                                                int* indices) {
+  // The pair owns the banks first_bank and first_bank + 1 (mod num_banks),
+  // seen as a single table of 2 * ENTRIES_PER_BANK entries in which entry
+  // 2 * set + way holds the given way of a set.
+  int entry = indices[0] << 1;
+  int bank =
+      (first_bank + (entry >> TAGE_CONFIG::LOG_ENTRIES_PER_BANK)) % num_banks;
+  indices[0] = (bank << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) +
+               (entry & ((1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) - 1));
+  indices[1] = indices[0] + 1;
+}
+
+template <class TAGE_CONFIG>
+int Tage<TAGE_CONFIG>::num_tagged_cache_lines(
+    const Tage_Prediction_Info<TAGE_CONFIG>& prediction_info) const {
+  constexpr int cache_line_size = 64;
+  uintptr_t lines[Tage_Enabled_Banks<TAGE_CONFIG>::NUM_BANKS];
+  int num_lines = 0;
+  for (int slot = 0; slot < Tage_Enabled_Banks<TAGE_CONFIG>::NUM_BANKS;
+       ++slot) {
+    const Tagged_Entry* entry =
+        &tagged_table_ptrs_[enabled_banks_.banks[slot]]
+                           [prediction_info.indices[slot]];
+    lines[num_lines++] = reinterpret_cast<uintptr_t>(entry) / cache_line_size;
   }
+  std::sort(lines, lines + num_lines);
+  return std::unique(lines, lines + num_lines) - lines;
 }
 
 template <class TAGE_CONFIG>
 Bimodal_Output Tage<TAGE_CONFIG>::get_bimodal_prediction_confidence(
     uint64_t br_pc) const {
   Bimodal_Output output;
-  int index = (br_pc ^ (br_pc >> 2)) &
-              ((1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE) - 1);
+  int index = get_bimodal_index(br_pc);
   int8_t bimodal_output =
       (bimodal_table_[index].prediction << 1) +
       (bimodal_table_[index >> TAGE_CONFIG::BIMODAL_HYSTERESIS_SHIFT]
@@ -843,8 +1611,7 @@ Bimodal_Output Tage<TAGE_CONFIG>::get_bimodal_prediction_confidence(
 
 template <class TAGE_CONFIG>
 void Tage<TAGE_CONFIG>::update_bimodal(uint64_t br_pc, bool resolve_dir) {
-  int index = (br_pc ^ (br_pc >> 2)) &
-              ((1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE) - 1);
+  int index = get_bimodal_index(br_pc);
   int8_t bimodal_output =
       (bimodal_table_[index].prediction << 1) +
       (bimodal_table_[index >> TAGE_CONFIG::BIMODAL_HYSTERESIS_SHIFT]
@@ -864,15 +1631,15 @@ Matched_Table_Banks Tage<TAGE_CONFIG>::get_two_longest_matching_tables(
     int indices[], int tags[]) const {
   int first_match = 0;
   int second_match = 0;
-  for (int i = 2 * TAGE_CONFIG::NUM_HISTORIES; i > 0; --i) {
-    if (tables_enabled_.arr[i]) {
-      if (tagged_table_ptrs_[i][indices[i]].tag == tags[i]) {
-        if (first_match == 0) {
-          first_match = i;
-        } else {
-          second_match = i;
-          break;
-        }
+  for (int slot = Tage_Enabled_Banks<TAGE_CONFIG>::NUM_BANKS - 1; slot >= 0;
+       --slot) {
+    int bank = enabled_banks_.banks[slot];
+    if (tagged_table_ptrs_[bank][indices[slot]].tag() == tags[slot]) {
+      if (first_match == 0) {
+        first_match = bank;
+      } else {
+        second_match = bank;
+        break;
       }
     }
   }
@@ -882,8 +1649,90 @@ Matched_Table_Banks Tage<TAGE_CONFIG>::get_two_longest_matching_tables(
 template <class TAGE_CONFIG>
 void Tage<TAGE_CONFIG>::shift_tage_useful_bits(Tagged_Entry* table, int size) {
   for (int i = 0; i < size; ++i) {
-    table[i].useful.set(table[i].useful.get() >> 1);
+    table[i].set_useful(table[i].useful() >> 1);
+  }
+}
+
+template <class TAGE_CONFIG>
+void Tage<TAGE_CONFIG>::save_state(State_Writer* writer) const {
+  tage_histories_->save_state(writer);
+  writer->write(bimodal_table_, 1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE);
+  writer->write(low_history_tagged_table_,
+                sizeof(low_history_tagged_table_) / sizeof(Tagged_Entry));
+  writer->write(high_history_tagged_table_,
+                sizeof(high_history_tagged_table_) / sizeof(Tagged_Entry));
+  writer->write(alt_selector_table_,
+                1 << TAGE_CONFIG::ALT_SELECTOR_LOG_TABLE_SIZE);
+  writer->write(tick_);
+}
+
+template <class TAGE_CONFIG>
+void Tage<TAGE_CONFIG>::load_state(State_Reader* reader) {
+  tage_histories_->load_state(reader);
+  for (auto& histories : thread_histories_) {
+    histories = *tage_histories_;
+  }
+  reader->read(bimodal_table_, 1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE);
+  reader->read(low_history_tagged_table_,
+               sizeof(low_history_tagged_table_) / sizeof(Tagged_Entry));
+  reader->read(high_history_tagged_table_,
+               sizeof(high_history_tagged_table_) / sizeof(Tagged_Entry));
+  reader->read(alt_selector_table_,
+               1 << TAGE_CONFIG::ALT_SELECTOR_LOG_TABLE_SIZE);
+  reader->read(&tick_);
+}
+
+template <class TAGE_CONFIG>
+void Tage<TAGE_CONFIG>::fingerprint_config(Config_Fingerprint* fingerprint) {
+  for (int64_t value :
+       {TAGE_CONFIG::MIN_HISTORY_SIZE, TAGE_CONFIG::MAX_HISTORY_SIZE,
+        TAGE_CONFIG::NUM_HISTORIES, TAGE_CONFIG::PATH_HISTORY_WIDTH,
+        TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE, TAGE_CONFIG::FIRST_2WAY_TABLE,
+        TAGE_CONFIG::LAST_2WAY_TABLE, TAGE_CONFIG::SHORT_HISTORY_TAG_BITS,
+        TAGE_CONFIG::LONG_HISTORY_TAG_BITS, TAGE_CONFIG::PRED_COUNTER_WIDTH,
+        TAGE_CONFIG::USEFUL_BITS, TAGE_CONFIG::LOG_ENTRIES_PER_BANK,
+        TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS,
+        TAGE_CONFIG::LONG_HISTORY_NUM_BANKS,
+        TAGE_CONFIG::EXTRA_ENTRIES_TO_ALLOCATE,
+        TAGE_CONFIG::TICKS_UNTIL_USEFUL_SHIFT,
+        TAGE_CONFIG::ALT_SELECTOR_LOG_TABLE_SIZE,
+        TAGE_CONFIG::ALT_SELECTOR_ENTRY_WIDTH,
+        TAGE_CONFIG::BIMODAL_HYSTERESIS_SHIFT,
+        TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE}) {
+    fingerprint->add(value);
+  }
+  fingerprint->add(TAGE_CONFIG::INTERLEAVE_2WAY_TABLES);
+}
+
+template <class TAGE_CONFIG>
+void Tage<TAGE_CONFIG>::append_statistics(
+    std::vector<Statistic>* statistics) const {
+  if (!TAGE_CONFIG::COLLECT_STATISTICS) {
+    return;
+  }
+  for (int i = 0; i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_;
+       ++i) {
+    statistics->push_back({"tage/provider_hits/" + std::to_string(i),
+                           statistics_.provider_hits[i]});
+  }
+  for (int i = 0; i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_;
+       ++i) {
+    statistics->push_back({"tage/provider_mispredictions/" + std::to_string(i),
+                           statistics_.provider_mispredictions[i]});
   }
+  statistics->insert(
+      statistics->end(),
+      {{"tage/alt_predictions", statistics_.alt_predictions},
+       {"tage/alt_mispredictions", statistics_.alt_mispredictions},
+       {"tage/alt_selector_updates", statistics_.alt_selector_updates},
+       {"tage/allocation_attempts", statistics_.allocation_attempts},
+       {"tage/allocated_entries", statistics_.allocated_entries},
+       {"tage/failed_allocations", statistics_.failed_allocations},
+       {"tage/useful_bit_resets", statistics_.useful_bit_resets},
+       {"tage/recoveries", statistics_.recoveries},
+       {"tage/recovered_history_bits", statistics_.recovered_history_bits}});
+  statistics_.recovered_history_bits_histogram.append_to(
+      "tage/recovered_history_bits_histogram", statistics);
 }
 
 }  // namespace tagescl
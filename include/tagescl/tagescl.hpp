@@ -22,6 +22,12 @@
 #ifndef SPEC_TAGE_SC_L_TAGESCL_HPP_
 #define SPEC_TAGE_SC_L_TAGESCL_HPP_
 
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "latency_profile.hpp"
 #include "statistical_corrector.hpp"
 #include "tage.hpp"
 #include "tagescl_configs.hpp"
@@ -39,6 +45,8 @@ struct Tage_SC_L_Prediction_Info {
   bool tage_or_loop_prediction;
   bool final_prediction;
   bool updated_history;
+  bool prefetched;
+  bool latency_sampled;
 };
 
 class Tage_SC_L_Base {
@@ -59,26 +67,47 @@ class Tage_SC_L_Base {
                                              Branch_Type br_type,
                                              bool resolve_dir,
                                              uint64_t br_target) = 0;
+  virtual bool save_state(const std::string& path) const = 0;
+  virtual bool load_state(const std::string& path) = 0;
 };
 
 /* Interface functions:
  *
- * warmup() a wrapper for updating predictor state during the warmup phase of a
- * simulation.
+ * update_batch() a wrapper for updating predictor state during the warmup phase
+ * of a simulation.
  *
- * predict_and_update() a wrapper for consecutive simultaneous prediction and
+ * predict_batch() a wrapper for consecutive simultaneous prediction and
  * update that implement the idealistic algorithms without considering pipeline
  * requirements. (same as Championship Branch Prediction Interface)
+ *
+ * save_state() and load_state() store the warmed-up state of the predictor in
+ * a file (see state_file.hpp) and restore it, so that several simulations can
+ * start from the same warmup.
  */
 template <class CONFIG>
 class Tage_SC_L : public Tage_SC_L_Base {
  public:
-  Tage_SC_L(int max_in_flight_branches)
-      : tage_(random_number_gen_, max_in_flight_branches),
-        statistical_corrector_(),
-        loop_predictor_(random_number_gen_),
+  // The predictor has a speculative context for each of num_threads hardware
+  // threads, with up to max_in_flight_branches branches in flight each (see
+  // set_active_thread()).
+  explicit Tage_SC_L(int max_in_flight_branches, int num_threads = 1)
+      : tage_(random_number_gen_, max_in_flight_branches, num_threads),
+        statistical_corrector_(num_threads),
+        loop_predictor_(random_number_gen_, num_threads),
         loop_predictor_beneficial_(-1),
-        prediction_info_buffer_(max_in_flight_branches) {}
+        thread_prediction_info_buffers_(
+            num_threads, Circular_Buffer<Tage_SC_L_Prediction_Info<CONFIG>>(
+                             max_in_flight_branches)),
+        prediction_info_buffer_(&thread_prediction_info_buffers_[0]),
+        thread_rng_seeds_(num_threads, 0),
+        latency_histograms_(CONFIG::PROFILE_LATENCIES ? NUM_LATENCY_PHASES
+                                                      : 0) {}
+
+  // The components and the active context point into the predictor itself.
+  Tage_SC_L(const Tage_SC_L&) = delete;
+  Tage_SC_L(Tage_SC_L&&) = delete;
+  Tage_SC_L& operator=(const Tage_SC_L&) = delete;
+  Tage_SC_L& operator=(Tage_SC_L&&) = delete;
 
   // Gets a new branch_id for a new in-flight branch. The id remains valid
   // until
@@ -86,12 +115,19 @@ class Tage_SC_L : public Tage_SC_L_Base {
   // for each in-flight branch. The rest of the public functions in this class
   // need the id of a branch to work on.
   uint32_t get_new_branch_id() override {
-    uint32_t branch_id = prediction_info_buffer_.allocate_back();
-    auto& prediction_info = prediction_info_buffer_[branch_id];
+    uint32_t branch_id = prediction_info_buffer_->allocate_back();
+    auto& prediction_info = (*prediction_info_buffer_)[branch_id];
     Tage<typename CONFIG::TAGE>::build_empty_prediction(&prediction_info.tage);
     Loop_Predictor<typename CONFIG::LOOP>::build_empty_prediction(
         &prediction_info.loop);
     prediction_info.updated_history = false;
+    prediction_info.prefetched = false;
+    if (CONFIG::PROFILE_LATENCIES) {
+      prediction_info.latency_sampled = branches_until_latency_sample_ == 0;
+      branches_until_latency_sample_ = prediction_info.latency_sampled
+                                           ? latency_sample_period_ - 1
+                                           : branches_until_latency_sample_ - 1;
+    }
     return branch_id;
   }
 
@@ -142,7 +178,120 @@ class Tage_SC_L : public Tage_SC_L_Base {
                                      Branch_Type br_type, bool resolve_dir,
                                      uint64_t br_target) override;
 
+  // Computes the table indices of the branch and prefetches the table entries
+  // that get_prediction() will read. It can be called as soon as the
+  // speculative state of all older branches has been updated, to hide cache
+  // misses behind the work still left for them (e.g. commit_state()).
+  // get_prediction() reuses the indices, so the speculative state must not
+  // change in between. It does not modify the predictor tables.
+  void prefetch(uint32_t branch_id, uint64_t br_pc);
+
+  // Processes the branches in order. Each branch gets a new id, is predicted,
+  // and then updated, committed and retired with its resolved direction, as
+  // the per-call interface would do without speculation. The prediction of
+  // branch i is stored in predictions[i]. There cannot be other branches in
+  // flight. Each branch is prefetched right after updating the speculative
+  // state of the previous one.
+  void predict_batch(const Branch_Record* branches, std::size_t num_branches,
+                     bool* predictions) {
+    process_batch<true>(branches, num_branches, predictions);
+  }
+
+  // Same as predict_batch(), but discarding the predictions.
+  void update_batch(const Branch_Record* branches, std::size_t num_branches) {
+    process_batch<false>(branches, num_branches, nullptr);
+  }
+
+  // Selects the hardware thread that the rest of the functions work on. Each
+  // thread has its own speculative histories, speculative loop iteration
+  // counts, branches in flight (their ids are only valid while their thread
+  // is active) and random number seed, and all of them share the tables.
+  // Thread 0 is active after the construction.
+  void set_active_thread(int thread_id) {
+    assert(0 <= thread_id && thread_id < num_threads());
+    if (thread_id == active_thread_) {
+      return;
+    }
+    thread_rng_seeds_[active_thread_] = random_number_gen_.seed_;
+    random_number_gen_.seed_ = thread_rng_seeds_[thread_id];
+    active_thread_ = thread_id;
+    prediction_info_buffer_ = &thread_prediction_info_buffers_[thread_id];
+    tage_.set_active_thread(thread_id);
+    statistical_corrector_.set_active_thread(thread_id);
+    loop_predictor_.set_active_thread(thread_id);
+  }
+
+  int num_threads() const {
+    return static_cast<int>(thread_prediction_info_buffers_.size());
+  }
+
+  // Saves the tables and the committed histories of the predictor to path.
+  // The histories are those of the active thread, and there cannot be
+  // branches in flight in it. Returns false if the file could not
+  // be written.
+  bool save_state(const std::string& path) const override;
+
+  // Replaces the state of the predictor with the one saved at path by a
+  // predictor of the same CONFIG. There cannot be branches in flight. Returns
+  // false, leaving the predictor unchanged, if the file is missing or was
+  // saved by another version or CONFIG. If the sections of an accepted file
+  // do not match the predictor, it also returns false, but the state of the
+  // predictor is then undefined. Every thread gets the saved histories, and
+  // there cannot be branches in flight in any of them.
+  bool load_state(const std::string& path) override;
+
+  // Hash of the parameters of CONFIG, stored in the state files.
+  static uint64_t config_fingerprint();
+
+  // Returns the counters of every component whose configuration sets
+  // COLLECT_STATISTICS (see With_Statistics), collected since the
+  // construction or the last reset_statistics(). The counters are plain
+  // integers: a predictor must not be used by several threads at once.
+  // If CONFIG::PROFILE_LATENCIES, it also returns the latency histograms,
+  // under "latency/", and "latency/ticks_per_second".
+  std::vector<Statistic> get_statistics() const;
+  void reset_statistics();
+
+  // With CONFIG::PROFILE_LATENCIES, the calls of get_prediction(),
+  // update_speculative_state(), commit_state(), flush_branch() and
+  // flush_branch_and_repair_state() are timed for one in every period new
+  // branch ids (64 by default).
+  void set_latency_sample_period(uint32_t period) {
+    assert(period > 0);
+    latency_sample_period_ = period;
+    branches_until_latency_sample_ = 0;
+  }
+
  private:
+  template <bool store_predictions>
+  void process_batch(const Branch_Record* branches, std::size_t num_branches,
+                     bool* predictions);
+
+  enum Latency_Phase {
+    GET_PREDICTION_LATENCY,
+    UPDATE_SPECULATIVE_STATE_LATENCY,
+    COMMIT_STATE_LATENCY,
+    FLUSH_BRANCH_LATENCY,
+    FLUSH_BRANCH_AND_REPAIR_STATE_LATENCY,
+    NUM_LATENCY_PHASES,
+  };
+
+  // The histogram a call of the phase for a branch adds its latency to, or
+  // null if it is not measured.
+  Latency_Histogram* latency_histogram(Latency_Phase phase, bool sampled) {
+    return CONFIG::PROFILE_LATENCIES && sampled ? &latency_histograms_[phase]
+                                                : nullptr;
+  }
+
+  // Counts a flush that removed num_flushed_branches from the buffer.
+  void record_flush(uint32_t num_flushed_branches) {
+    if (CONFIG::COLLECT_STATISTICS) {
+      statistics_.flushes += 1;
+      statistics_.flushed_branches += num_flushed_branches;
+      statistics_.flush_depth_histogram.add(num_flushed_branches);
+    }
+  }
+
   Random_Number_Generator random_number_gen_;
   Tage<typename CONFIG::TAGE> tage_;
   Statistical_Corrector<CONFIG> statistical_corrector_;
@@ -154,16 +303,43 @@ class Tage_SC_L : public Tage_SC_L_Base {
 
   // Used for remembering necessary information gathered during prediction
   // that
-  // are needed for update.
-  Circular_Buffer<Tage_SC_L_Prediction_Info<CONFIG>> prediction_info_buffer_;
+  // are needed for update. One per thread.
+  std::vector<Circular_Buffer<Tage_SC_L_Prediction_Info<CONFIG>>>
+      thread_prediction_info_buffers_;
+  // The buffer of the active thread.
+  Circular_Buffer<Tage_SC_L_Prediction_Info<CONFIG>>* prediction_info_buffer_;
+  // The random number seeds of the threads that are not active. The active
+  // thread uses the one in random_number_gen_.
+  std::vector<int> thread_rng_seeds_;
+  int active_thread_ = 0;
+
+  // Counters of the decisions taken at this level, only updated if
+  // CONFIG::COLLECT_STATISTICS. A loop override is a loop prediction that
+  // replaced a different TAGE prediction.
+  struct Statistics {
+    int64_t loop_overrides = 0;
+    int64_t correct_loop_overrides = 0;
+    int64_t flushes = 0;
+    int64_t flushed_branches = 0;
+    Log2_Histogram<16> flush_depth_histogram;
+  };
+  Statistics statistics_;
+
+  // Empty unless CONFIG::PROFILE_LATENCIES.
+  std::vector<Latency_Histogram> latency_histograms_;
+  uint32_t latency_sample_period_ = 64;
+  uint32_t branches_until_latency_sample_ = 0;
 };
 
 template <class CONFIG>
 bool Tage_SC_L<CONFIG>::get_prediction(uint32_t branch_id, uint64_t br_pc) {
-  auto& prediction_info = prediction_info_buffer_[branch_id];
+  auto& prediction_info = (*prediction_info_buffer_)[branch_id];
+  Latency_Sample latency_sample(latency_histogram(
+      GET_PREDICTION_LATENCY, prediction_info.latency_sampled));
 
   // First, use Tage to make a prediction.
-  tage_.get_prediction(br_pc, &prediction_info.tage);
+  tage_.get_prediction(br_pc, &prediction_info.tage,
+                       prediction_info.prefetched);
   prediction_info.tage_or_loop_prediction = prediction_info.tage.prediction;
 
   if (CONFIG::USE_LOOP_PREDICTOR) {
@@ -192,7 +368,9 @@ void Tage_SC_L<CONFIG>::commit_state(uint32_t branch_id, uint64_t br_pc,
   if (!br_type.is_conditional) {
     return;
   }
-  auto& prediction_info = prediction_info_buffer_[branch_id];
+  auto& prediction_info = (*prediction_info_buffer_)[branch_id];
+  Latency_Sample latency_sample(latency_histogram(
+      COMMIT_STATE_LATENCY, prediction_info.latency_sampled));
   if (CONFIG::USE_SC) {
     statistical_corrector_.commit_state(
         br_pc, resolve_dir, prediction_info.tage, prediction_info.sc,
@@ -200,6 +378,13 @@ void Tage_SC_L<CONFIG>::commit_state(uint32_t branch_id, uint64_t br_pc,
   }
 
   if (CONFIG::USE_LOOP_PREDICTOR) {
+    if (CONFIG::COLLECT_STATISTICS &&
+        prediction_info.tage_or_loop_prediction !=
+            prediction_info.tage.prediction) {
+      statistics_.loop_overrides += 1;
+      statistics_.correct_loop_overrides +=
+          prediction_info.tage_or_loop_prediction == resolve_dir;
+    }
     if (prediction_info.loop.valid) {
       if (prediction_info.final_prediction != prediction_info.loop.prediction) {
         loop_predictor_beneficial_.update(resolve_dir ==
@@ -222,11 +407,16 @@ void Tage_SC_L<CONFIG>::flush_branch_and_repair_state(uint32_t branch_id,
                                                       Branch_Type br_type,
                                                       bool resolve_dir,
                                                       uint64_t br_target) {
+  Latency_Sample latency_sample(
+      latency_histogram(FLUSH_BRANCH_AND_REPAIR_STATE_LATENCY,
+                        (*prediction_info_buffer_)[branch_id].latency_sampled));
+  record_flush(prediction_info_buffer_->back_id() - branch_id);
+
   // First iterate over all flushed branches from youngest to oldest and call
   // local recovery functions.
-  for (uint32_t id = prediction_info_buffer_.back_id();
+  for (uint32_t id = prediction_info_buffer_->back_id();
        id - branch_id < (uint32_t{1} << 31); --id) {
-    auto& prediction_info = prediction_info_buffer_[id];
+    auto& prediction_info = (*prediction_info_buffer_)[id];
     tage_.local_recover_speculative_state(prediction_info.tage);
     if (CONFIG::USE_LOOP_PREDICTOR) {
       loop_predictor_.local_recover_speculative_state(prediction_info.loop);
@@ -236,10 +426,10 @@ void Tage_SC_L<CONFIG>::flush_branch_and_repair_state(uint32_t branch_id,
           prediction_info.br_pc, prediction_info.sc);
     }
   }
-  prediction_info_buffer_.deallocate_after(branch_id);
+  prediction_info_buffer_->deallocate_after(branch_id);
 
   // Now call global recovery functions.
-  auto& prediction_info = prediction_info_buffer_[branch_id];
+  auto& prediction_info = (*prediction_info_buffer_)[branch_id];
   tage_.global_recover_speculative_state(prediction_info.tage);
   if (CONFIG::USE_LOOP_PREDICTOR) {
     loop_predictor_.global_recover_speculative_state(prediction_info.loop);
@@ -265,11 +455,16 @@ void Tage_SC_L<CONFIG>::flush_branch_and_repair_state(uint32_t branch_id,
 
 template <class CONFIG>
 void Tage_SC_L<CONFIG>::flush_branch(uint32_t branch_id) {
+  Latency_Sample latency_sample(
+      latency_histogram(FLUSH_BRANCH_LATENCY,
+                        (*prediction_info_buffer_)[branch_id].latency_sampled));
+  record_flush(prediction_info_buffer_->back_id() - branch_id + 1);
+
   // First iterate over all flushed branches from youngest to oldest and
   // call local recovery functions.
-  for (uint32_t id = prediction_info_buffer_.back_id();
+  for (uint32_t id = prediction_info_buffer_->back_id();
        id - branch_id < (uint32_t{1} << 31); --id) {
-    auto& prediction_info = prediction_info_buffer_[id];
+    auto& prediction_info = (*prediction_info_buffer_)[id];
     tage_.local_recover_speculative_state(prediction_info.tage);
     if (CONFIG::USE_LOOP_PREDICTOR) {
       loop_predictor_.local_recover_speculative_state(prediction_info.loop);
@@ -280,8 +475,8 @@ void Tage_SC_L<CONFIG>::flush_branch(uint32_t branch_id) {
     }
   }
 
-  auto& prediction_info = prediction_info_buffer_[branch_id];
-  prediction_info_buffer_.deallocate_and_after(branch_id);
+  auto& prediction_info = (*prediction_info_buffer_)[branch_id];
+  prediction_info_buffer_->deallocate_and_after(branch_id);
 
   // Now call global recovery functions.
   tage_.global_recover_speculative_state(prediction_info.tage);
@@ -301,7 +496,7 @@ void Tage_SC_L<CONFIG>::commit_state_at_retire(uint32_t branch_id,
                                                Branch_Type br_type,
                                                bool resolve_dir,
                                                uint64_t br_target) {
-  auto& prediction_info = prediction_info_buffer_[branch_id];
+  auto& prediction_info = (*prediction_info_buffer_)[branch_id];
   if (prediction_info.updated_history) {
     if (CONFIG::USE_LOOP_PREDICTOR) {
       loop_predictor_.commit_state_at_retire(
@@ -314,13 +509,57 @@ void Tage_SC_L<CONFIG>::commit_state_at_retire(uint32_t branch_id,
       statistical_corrector_.commit_state_at_retire();
     }
   }
-  prediction_info_buffer_.deallocate_front(branch_id);
+  prediction_info_buffer_->deallocate_front(branch_id);
+}
+
+template <class CONFIG>
+template <bool store_predictions>
+void Tage_SC_L<CONFIG>::process_batch(const Branch_Record* branches,
+                                      std::size_t num_branches,
+                                      bool* predictions) {
+  if (num_branches == 0) {
+    return;
+  }
+
+  // The calls are qualified so that they are not dispatched virtually.
+  uint32_t branch_id = Tage_SC_L::get_new_branch_id();
+  for (std::size_t i = 0; i < num_branches; ++i) {
+    const Branch_Record& branch = branches[i];
+    bool prediction = Tage_SC_L::get_prediction(branch_id, branch.br_pc);
+    if (store_predictions) {
+      predictions[i] = prediction;
+    }
+    Tage_SC_L::update_speculative_state(branch_id, branch.br_pc,
+                                        branch.br_type, branch.resolve_dir,
+                                        branch.br_target);
+    // The next branch enters the pipeline before this one retires.
+    uint32_t next_branch_id = 0;
+    if (i + 1 < num_branches) {
+      next_branch_id = Tage_SC_L::get_new_branch_id();
+      prefetch(next_branch_id, branches[i + 1].br_pc);
+    }
+    Tage_SC_L::commit_state(branch_id, branch.br_pc, branch.br_type,
+                            branch.resolve_dir);
+    Tage_SC_L::commit_state_at_retire(branch_id, branch.br_pc, branch.br_type,
+                                      branch.resolve_dir, branch.br_target);
+    branch_id = next_branch_id;
+  }
+}
+
+template <class CONFIG>
+void Tage_SC_L<CONFIG>::prefetch(uint32_t branch_id, uint64_t br_pc) {
+  auto& prediction_info = (*prediction_info_buffer_)[branch_id];
+  tage_.prefetch(br_pc, &prediction_info.tage);
+  prediction_info.prefetched = true;
+  if (CONFIG::USE_SC) {
+    statistical_corrector_.prefetch(br_pc);
+  }
 }
 
 template <class CONFIG>
 void Tage_SC_L<CONFIG>::retire_non_branch_ip(uint32_t branch_id) {
   // std::cerr << "retire_non_branch_ip(" << branch_id << ")\n";
-  prediction_info_buffer_.deallocate_front(branch_id);
+  prediction_info_buffer_->deallocate_front(branch_id);
 }
 
 template <class CONFIG>
@@ -329,7 +568,9 @@ void Tage_SC_L<CONFIG>::update_speculative_state(uint32_t branch_id,
                                                  Branch_Type br_type,
                                                  bool branch_dir,
                                                  uint64_t br_target) {
-  auto& prediction_info = prediction_info_buffer_[branch_id];
+  auto& prediction_info = (*prediction_info_buffer_)[branch_id];
+  Latency_Sample latency_sample(latency_histogram(
+      UPDATE_SPECULATIVE_STATE_LATENCY, prediction_info.latency_sampled));
   prediction_info.rng_seed = random_number_gen_.seed_;
   prediction_info.updated_history = true;
   tage_.update_speculative_state(br_pc, br_target, br_type, branch_dir,
@@ -344,6 +585,98 @@ void Tage_SC_L<CONFIG>::update_speculative_state(uint32_t branch_id,
   prediction_info.br_pc = br_pc;
 }
 
+template <class CONFIG>
+bool Tage_SC_L<CONFIG>::save_state(const std::string& path) const {
+  assert(prediction_info_buffer_->size() == 0);
+  State_Writer writer;
+  writer.write(random_number_gen_.seed_);
+  writer.write(loop_predictor_beneficial_);
+  tage_.save_state(&writer);
+  statistical_corrector_.save_state(&writer);
+  loop_predictor_.save_state(&writer);
+  return writer.save(path, config_fingerprint());
+}
+
+template <class CONFIG>
+bool Tage_SC_L<CONFIG>::load_state(const std::string& path) {
+  for (const auto& buffer : thread_prediction_info_buffers_) {
+    assert(buffer.size() == 0);
+  }
+  State_Reader reader(path, config_fingerprint());
+  if (!reader.ok()) {
+    return false;
+  }
+  reader.read(&random_number_gen_.seed_);
+  std::fill(thread_rng_seeds_.begin(), thread_rng_seeds_.end(),
+            random_number_gen_.seed_);
+  reader.read(&loop_predictor_beneficial_);
+  tage_.load_state(&reader);
+  statistical_corrector_.load_state(&reader);
+  loop_predictor_.load_state(&reader);
+  return reader.done();
+}
+
+template <class CONFIG>
+uint64_t Tage_SC_L<CONFIG>::config_fingerprint() {
+  Config_Fingerprint fingerprint;
+  fingerprint.add(CONFIG::USE_LOOP_PREDICTOR);
+  fingerprint.add(CONFIG::USE_SC);
+  fingerprint.add(CONFIG::CONFIDENCE_COUNTER_WIDTH);
+  Tage<typename CONFIG::TAGE>::fingerprint_config(&fingerprint);
+  Statistical_Corrector<CONFIG>::fingerprint_config(&fingerprint);
+  Loop_Predictor<typename CONFIG::LOOP>::fingerprint_config(&fingerprint);
+  return fingerprint.value();
+}
+
+template <class CONFIG>
+std::vector<Statistic> Tage_SC_L<CONFIG>::get_statistics() const {
+  std::vector<Statistic> statistics;
+  tage_.append_statistics(&statistics);
+  if (CONFIG::USE_LOOP_PREDICTOR) {
+    loop_predictor_.append_statistics(&statistics);
+  }
+  if (CONFIG::USE_SC) {
+    statistical_corrector_.append_statistics(&statistics);
+  }
+  if (CONFIG::COLLECT_STATISTICS) {
+    if (CONFIG::USE_LOOP_PREDICTOR) {
+      statistics.insert(
+          statistics.end(),
+          {{"loop/overrides", statistics_.loop_overrides},
+           {"loop/correct_overrides", statistics_.correct_loop_overrides}});
+    }
+    statistics.insert(
+        statistics.end(),
+        {{"recovery/flushes", statistics_.flushes},
+         {"recovery/flushed_branches", statistics_.flushed_branches}});
+    statistics_.flush_depth_histogram.append_to(
+        "recovery/flush_depth_histogram", &statistics);
+  }
+  if (CONFIG::PROFILE_LATENCIES) {
+    static const char* const phase_names[] = {
+        "get_prediction", "update_speculative_state", "commit_state",
+        "flush_branch", "flush_branch_and_repair_state"};
+    for (int i = 0; i < NUM_LATENCY_PHASES; ++i) {
+      latency_histograms_[i].append_to(
+          std::string("latency/") + phase_names[i], &statistics);
+    }
+    statistics.push_back(
+        {"latency/ticks_per_second", timestamp_ticks_per_second()});
+  }
+  return statistics;
+}
+
+template <class CONFIG>
+void Tage_SC_L<CONFIG>::reset_statistics() {
+  tage_.reset_statistics();
+  loop_predictor_.reset_statistics();
+  statistical_corrector_.reset_statistics();
+  statistics_ = {};
+  for (Latency_Histogram& histogram : latency_histograms_) {
+    histogram = {};
+  }
+}
+
 }  // namespace tagescl
 
 #endif  // SPEC_TAGE_SC_L_TAGESCL_HPP_
@@ -29,6 +29,11 @@ struct CONFIG_64KB {
   static constexpr bool USE_LOOP_PREDICTOR = true;
   static constexpr bool USE_SC = true;
   static constexpr int CONFIDENCE_COUNTER_WIDTH = 7;
+  // Count the loop overrides and the flushes.
+  static constexpr bool COLLECT_STATISTICS = false;
+  // Measure the latency of a sample of the calls to Tage_SC_L (see
+  // Tage_SC_L::set_latency_sample_period()).
+  static constexpr bool PROFILE_LATENCIES = false;
 
   struct TAGE {
     static constexpr int MIN_HISTORY_SIZE = 6;
@@ -51,6 +56,17 @@ struct CONFIG_64KB {
     static constexpr int ALT_SELECTOR_ENTRY_WIDTH = 5;
     static constexpr int BIMODAL_HYSTERESIS_SHIFT = 2;
     static constexpr int BIMODAL_LOG_TABLES_SIZE = 13;
+    // Keep a copy of the folded histories for every in-flight branch, so that
+    // recovering from a misprediction does not need to rewind the history
+    // bit by bit (3 * NUM_HISTORIES 32-bit values, 216 bytes per in-flight
+    // branch). See With_Folded_History_Checkpoints.
+    static constexpr bool CHECKPOINT_FOLDED_HISTORIES = false;
+    // Store the two ways of each 2-way table pair in adjacent entries, so that
+    // a prediction reads both from the same cache line. This changes the index
+    // function of the second way, and therefore the predictions.
+    static constexpr bool INTERLEAVE_2WAY_TABLES = false;
+    // Count the providers, the allocations and the useful bit resets.
+    static constexpr bool COLLECT_STATISTICS = false;
   };
 
   struct LOOP {
@@ -58,6 +74,7 @@ struct CONFIG_64KB {
     static constexpr int ITERATION_COUNTER_WIDTH = 10;
     static constexpr int TAG_BITS = 10;
     static constexpr int CONFIDENCE_THRESHOLD = 15;
+    static constexpr bool COLLECT_STATISTICS = false;
   };
 
   struct SC {
@@ -122,6 +139,9 @@ struct CONFIG_64KB {
 
     static constexpr int PRECISION = 6;
     static constexpr int SC_PATH_HISTORY_WIDTH = 27;
+
+    // Count the overrides of the TAGE prediction by confidence class.
+    static constexpr bool COLLECT_STATISTICS = false;
   };
 };
 
@@ -139,6 +159,11 @@ struct CONFIG_80KB {
   static constexpr bool USE_LOOP_PREDICTOR = true;
   static constexpr bool USE_SC = true;
   static constexpr int CONFIDENCE_COUNTER_WIDTH = 7;
+  // Count the loop overrides and the flushes.
+  static constexpr bool COLLECT_STATISTICS = false;
+  // Measure the latency of a sample of the calls to Tage_SC_L (see
+  // Tage_SC_L::set_latency_sample_period()).
+  static constexpr bool PROFILE_LATENCIES = false;
 
   struct TAGE {
     static constexpr int MIN_HISTORY_SIZE = 6;
@@ -161,6 +186,17 @@ struct CONFIG_80KB {
     static constexpr int ALT_SELECTOR_ENTRY_WIDTH = 5;
     static constexpr int BIMODAL_HYSTERESIS_SHIFT = 2;
     static constexpr int BIMODAL_LOG_TABLES_SIZE = 13;
+    // Keep a copy of the folded histories for every in-flight branch, so that
+    // recovering from a misprediction does not need to rewind the history
+    // bit by bit (3 * NUM_HISTORIES 32-bit values, 216 bytes per in-flight
+    // branch). See With_Folded_History_Checkpoints.
+    static constexpr bool CHECKPOINT_FOLDED_HISTORIES = false;
+    // Store the two ways of each 2-way table pair in adjacent entries, so that
+    // a prediction reads both from the same cache line. This changes the index
+    // function of the second way, and therefore the predictions.
+    static constexpr bool INTERLEAVE_2WAY_TABLES = false;
+    // Count the providers, the allocations and the useful bit resets.
+    static constexpr bool COLLECT_STATISTICS = false;
   };
 
   struct LOOP {
@@ -168,6 +204,7 @@ struct CONFIG_80KB {
     static constexpr int ITERATION_COUNTER_WIDTH = 10;
     static constexpr int TAG_BITS = 10;
     static constexpr int CONFIDENCE_THRESHOLD = 15;
+    static constexpr bool COLLECT_STATISTICS = false;
   };
 
   struct SC {
@@ -232,6 +269,9 @@ struct CONFIG_80KB {
 
     static constexpr int PRECISION = 8;
     static constexpr int SC_PATH_HISTORY_WIDTH = 27;
+
+    // Count the overrides of the TAGE prediction by confidence class.
+    static constexpr bool COLLECT_STATISTICS = false;
   };
 };
 
@@ -243,6 +283,44 @@ constexpr int CONFIG_80KB::SC::THIRD_LOCAL_GEHL_HISTORIES::arr[];
 constexpr int CONFIG_80KB::SC::FIRST_IMLI_GEHL_HISTORIES::arr[];
 constexpr int CONFIG_80KB::SC::SECOND_IMLI_GEHL_HISTORIES::arr[];
 
+// CONFIG with the statistics of every component enabled, as returned by
+// Tage_SC_L::get_statistics(). Each component counts its own events when the
+// COLLECT_STATISTICS flag of its configuration is set. The predictions are the
+// same as those of CONFIG.
+template <class CONFIG>
+struct With_Statistics : CONFIG {
+  static constexpr bool COLLECT_STATISTICS = true;
+
+  struct TAGE : CONFIG::TAGE {
+    static constexpr bool COLLECT_STATISTICS = true;
+  };
+
+  struct LOOP : CONFIG::LOOP {
+    static constexpr bool COLLECT_STATISTICS = true;
+  };
+
+  struct SC : CONFIG::SC {
+    static constexpr bool COLLECT_STATISTICS = true;
+  };
+};
+
+// CONFIG with the folded histories checkpointed for every in-flight branch,
+// which makes recoveries faster at the cost of 216 more bytes per in-flight
+// branch. The predictions are the same as those of CONFIG.
+template <class CONFIG>
+struct With_Folded_History_Checkpoints : CONFIG {
+  struct TAGE : CONFIG::TAGE {
+    static constexpr bool CHECKPOINT_FOLDED_HISTORIES = true;
+  };
+};
+
+// CONFIG with the latencies of the calls to Tage_SC_L measured. It can wrap
+// a With_Statistics configuration.
+template <class CONFIG>
+struct With_Latency_Profiling : CONFIG {
+  static constexpr bool PROFILE_LATENCIES = true;
+};
+
 }  // namespace tagescl
 
 #endif  // SPEC_TAGE_SC_L_TAGESCL_CONFIGS_HPP_
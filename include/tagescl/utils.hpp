@@ -23,6 +23,9 @@
 #define SPEC_TAGE_SC_L_UTILS_HPP_
 
 #include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace tagescl {
 
@@ -67,6 +70,16 @@ struct Smallest_Int_Type {
                                     int64_t>::type>::type>::type;
 };
 
+template <int width>
+struct Smallest_Uint_Type {
+  using type = typename conditional_type<
+      (width <= 8), uint8_t,
+      typename conditional_type<
+          (width <= 16), uint16_t,
+          typename conditional_type<(width <= 32), uint32_t,
+                                    uint64_t>::type>::type>::type;
+};
+
 /* Saturating counters: Could be signed or unsigned. Can be
  * directly updated using increment() or decrement(). Alternatively, one can
  * call upodate with a boolean indicting the direction.  */
@@ -146,6 +159,14 @@ struct Branch_Type {
   bool is_indirect;
 };
 
+// A branch whose outcome is already known, e.g. read from a trace.
+struct Branch_Record {
+  uint64_t br_pc;
+  uint64_t br_target;
+  Branch_Type br_type;
+  bool resolve_dir;
+};
+
 template <typename T>
 class Circular_Buffer {
  public:
@@ -163,6 +184,8 @@ class Circular_Buffer {
 
   uint32_t back_id() const { return back_; }
 
+  uint32_t size() const { return size_; }
+
   void deallocate_after(uint32_t id) {
     assert(back_ - id < back_ - front_);
     size_ -= (back_ - id);
@@ -198,6 +221,35 @@ class Circular_Buffer {
   uint32_t size_;
 };
 
+// A counter collected by a predictor component whose configuration sets
+// COLLECT_STATISTICS. The name is a path like "tage/allocations"; the buckets
+// of a histogram are numbered from 0, as in
+// "recovery/flush_depth_histogram/3".
+struct Statistic {
+  std::string name;
+  int64_t value;
+};
+
+// Histogram of non-negative values in power-of-two buckets: bucket 0 counts
+// the zeros and bucket i the values in [2^(i-1), 2^i). The last bucket also
+// counts all larger values.
+template <int NUM_BUCKETS>
+struct Log2_Histogram {
+  void add(uint64_t value) {
+    int bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+    buckets[bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1] += 1;
+  }
+
+  void append_to(const std::string& name,
+                 std::vector<Statistic>* statistics) const {
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+      statistics->push_back({name + "/" + std::to_string(i), buckets[i]});
+    }
+  }
+
+  int64_t buckets[NUM_BUCKETS] = {};
+};
+
 }  // namespace tagescl
 
 #endif  // SPEC_TAGE_SC_L_UTILS_HPP_
@@ -0,0 +1,190 @@
+#ifndef SPEC_TAGE_SC_L_TEST_SBBT_BRANCH_SOURCE_HPP_
+#define SPEC_TAGE_SC_L_TEST_SBBT_BRANCH_SOURCE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mbp/sim/sbbt_reader.hpp>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "columnar_trace.hpp"
+
+// Consecutive branches of a trace, in columns. The flags are those of
+// columnar_trace.hpp.
+struct BranchBatch {
+  const std::int64_t* instrNums = nullptr;
+  const std::uint64_t* ips = nullptr;
+  const std::uint64_t* targets = nullptr;
+  const std::uint8_t* flags = nullptr;
+  std::size_t size = 0;
+};
+
+// Storage for the branches a BranchSource decodes.
+struct BranchBlock {
+  void Resize(std::size_t size) {
+    instrNums.resize(size);
+    ips.resize(size);
+    targets.resize(size);
+    flags.resize(size);
+  }
+
+  BranchBatch View(std::size_t size) const {
+    return {instrNums.data(), ips.data(), targets.data(), flags.data(), size};
+  }
+
+  std::vector<std::int64_t> instrNums;
+  std::vector<std::uint64_t> ips;
+  std::vector<std::uint64_t> targets;
+  std::vector<std::uint8_t> flags;
+};
+
+// What the reports need to know about the trace once it has been read.
+struct TraceSummary {
+  std::int64_t numInstructions;
+  std::int64_t lastInstrRead;
+  bool eof;
+  // Distinct ips of the branches before stopAtInstr.
+  std::size_t numBranchIps;
+};
+
+// Reads the branches of a trace up to stopAtInstr in batches.
+class BranchSource {
+ public:
+  virtual ~BranchSource() = default;
+
+  // Returns the next batch of at most maxBranches branches. Branches that
+  // must be decoded are stored in block; the others are returned in place.
+  // The last batch ends with the first branch that reaches stopAtInstr, or
+  // with the kEndOfTrace branch, and the batches after it are empty.
+  virtual BranchBatch Next(std::size_t maxBranches, BranchBlock* block) = 0;
+
+  // Valid after the last batch.
+  virtual TraceSummary Summary() const = 0;
+};
+
+inline std::uint8_t BranchFlags(const mbp::Branch& b) {
+  return (b.isTaken() ? kBranchTaken : 0) |
+         (b.isConditional() ? kBranchConditional : 0) |
+         (b.isIndirect() ? kBranchIndirect : 0);
+}
+
+// Decodes an SBBT trace with MBPlib.
+class SbbtBranchSource final : public BranchSource {
+ public:
+  SbbtBranchSource(const std::string& tracepath, std::int64_t stopAtInstr)
+      : trace_{tracepath}, stopAtInstr_(stopAtInstr) {}
+
+  BranchBatch Next(std::size_t maxBranches, BranchBlock* block) override {
+    block->Resize(maxBranches);
+    std::size_t n = 0;
+    mbp::Branch b;
+    while (n < maxBranches && !done_) {
+      std::int64_t instrNum = trace_.nextBranch(b);
+      block->instrNums[n] = instrNum;
+      block->ips[n] = b.ip();
+      block->targets[n] = b.target();
+      block->flags[n] = BranchFlags(b);
+      ++n;
+      if (instrNum >= stopAtInstr_) {
+        done_ = true;
+      } else {
+        branchIps_.insert(b.ip());
+      }
+    }
+    return block->View(n);
+  }
+
+  TraceSummary Summary() const override {
+    return {trace_.numInstructions(), trace_.lastInstrRead(), trace_.eof(),
+            branchIps_.size()};
+  }
+
+ private:
+  mbp::SbbtReader trace_;
+  const std::int64_t stopAtInstr_;
+  bool done_ = false;
+  std::unordered_set<std::uint64_t> branchIps_;
+};
+
+// Replays a columnar trace: in place if it is raw, decoding it if it is
+// packed.
+class ColumnarBranchSource final : public BranchSource {
+ public:
+  ColumnarBranchSource(const std::string& tracepath, std::int64_t stopAtInstr)
+      : trace_(tracepath), decoder_(trace_), stopAtInstr_(stopAtInstr) {
+    const std::uint64_t numBranches = trace_.header().numBranches;
+    if (trace_.header().encoding == ColumnarEncoding::kRaw) {
+      // The sentinel reaches any stopAtInstr.
+      last_ = std::lower_bound(trace_.instrNums(),
+                               trace_.instrNums() + numBranches + 1,
+                               stopAtInstr) -
+              trace_.instrNums();
+    }
+  }
+
+  BranchBatch Next(std::size_t maxBranches, BranchBlock* block) override {
+    if (done_) return {};
+    if (trace_.header().encoding == ColumnarEncoding::kPacked) {
+      return NextPacked(maxBranches, block);
+    }
+    std::size_t n = std::min<std::uint64_t>(maxBranches, last_ + 1 - next_);
+    std::uint64_t end = std::min<std::uint64_t>(next_ + n, last_);
+    for (std::uint64_t i = next_; i < end; ++i) {
+      numBranchIps_ += (trace_.flags()[i] & kBranchNewIp) != 0;
+    }
+    BranchBatch batch = {trace_.instrNums() + next_, trace_.ips() + next_,
+                         trace_.targets() + next_, trace_.flags() + next_, n};
+    next_ += n;
+    done_ = next_ > last_;
+    eof_ = done_ && last_ == trace_.header().numBranches;
+    return batch;
+  }
+
+  TraceSummary Summary() const override {
+    return {trace_.header().numInstructions, trace_.header().lastInstrRead,
+            eof_, numBranchIps_};
+  }
+
+ private:
+  BranchBatch NextPacked(std::size_t maxBranches, BranchBlock* block) {
+    block->Resize(maxBranches);
+    std::size_t n = 0;
+    while (n < maxBranches && !done_) {
+      decoder_.Next(&block->instrNums[n], &block->ips[n], &block->targets[n],
+                    &block->flags[n]);
+      if (block->instrNums[n] >= stopAtInstr_) {
+        done_ = true;
+        eof_ = block->instrNums[n] == kEndOfTrace &&
+               decoder_.index() == trace_.header().numBranches;
+      } else {
+        numBranchIps_ += (block->flags[n] & kBranchNewIp) != 0;
+      }
+      ++n;
+    }
+    return block->View(n);
+  }
+
+  ColumnarTrace trace_;
+  ColumnarTrace::Decoder decoder_;
+  const std::int64_t stopAtInstr_;
+  // Raw traces: the next branch to return and the last one.
+  std::uint64_t next_ = 0;
+  std::uint64_t last_ = 0;
+  bool done_ = false;
+  bool eof_ = false;
+  std::size_t numBranchIps_ = 0;
+};
+
+// Opens a columnar trace or, if tracepath is not one, an SBBT trace.
+inline std::unique_ptr<BranchSource> OpenBranchSource(
+    const std::string& tracepath, std::int64_t stopAtInstr) {
+  if (ColumnarTrace::IsColumnarTrace(tracepath)) {
+    return std::make_unique<ColumnarBranchSource>(tracepath, stopAtInstr);
+  }
+  return std::make_unique<SbbtBranchSource>(tracepath, stopAtInstr);
+}
+
+#endif  // SPEC_TAGE_SC_L_TEST_SBBT_BRANCH_SOURCE_HPP_
@@ -0,0 +1,362 @@
+#ifndef SPEC_TAGE_SC_L_TEST_SBBT_COLUMNAR_TRACE_HPP_
+#define SPEC_TAGE_SC_L_TEST_SBBT_COLUMNAR_TRACE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Pre-decoded branch traces, converted once from SBBT by sbbt_to_columnar and
+// mapped by the simulators. A file is a ColumnarTraceHeader followed by four
+// columns, each starting at a multiple of kColumnarTraceAlignment bytes: the
+// instruction number, ip, target and flags of every branch. Values are stored
+// in the byte order of the writer.
+//
+// Raw files store the columns as plain arrays, followed by a sentinel branch
+// numbered kEndOfTrace, and are replayed in place. Packed files store the
+// instruction numbers as deltas, the ips as deltas to the previous ip and the
+// targets as deltas to their ip, all as LEB128 varints (zigzag-encoded when
+// signed), and the flags in four bits. They are several times smaller, but
+// must be decoded.
+
+constexpr char kColumnarTraceMagic[8] = {'S', 'B', 'B', 'T', 'C', 'O', 'L',
+                                         '\0'};
+constexpr std::uint32_t kColumnarTraceVersion = 1;
+constexpr std::uint32_t kColumnarTraceByteOrderMark = 0x01020304;
+constexpr std::size_t kColumnarTraceAlignment = 64;
+
+// The instruction number returned at the end of a trace, as MBPlib does.
+constexpr std::int64_t kEndOfTrace = std::numeric_limits<std::int64_t>::max();
+
+// Branch flags.
+constexpr std::uint8_t kBranchTaken = 1;
+constexpr std::uint8_t kBranchConditional = 2;
+constexpr std::uint8_t kBranchIndirect = 4;
+// The first branch of the trace with its ip.
+constexpr std::uint8_t kBranchNewIp = 8;
+
+enum class ColumnarEncoding : std::uint32_t { kRaw = 0, kPacked = 1 };
+
+enum ColumnarTraceColumn {
+  kInstrNumColumn,
+  kIpColumn,
+  kTargetColumn,
+  kFlagsColumn,
+  kNumColumns,
+};
+
+struct alignas(kColumnarTraceAlignment) ColumnarTraceHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrderMark;
+  ColumnarEncoding encoding;
+  std::uint32_t reserved;
+  // Without the sentinel.
+  std::uint64_t numBranches;
+  // mbp::SbbtReader::numInstructions() and lastInstrRead() at the end of the
+  // trace.
+  std::int64_t numInstructions;
+  std::int64_t lastInstrRead;
+  std::uint64_t fileSize;
+  // In bytes, from the start of the file.
+  std::uint64_t columnOffsets[kNumColumns];
+  std::uint64_t columnSizes[kNumColumns];
+};
+
+// Builds a columnar trace in memory, one branch at a time, and writes it out
+// with Save().
+class ColumnarTraceWriter {
+ public:
+  explicit ColumnarTraceWriter(ColumnarEncoding encoding)
+      : encoding_(encoding) {}
+
+  void Add(std::int64_t instrNum, std::uint64_t ip, std::uint64_t target,
+           std::uint8_t flags) {
+    if (encoding_ == ColumnarEncoding::kRaw) {
+      AppendRaw(kInstrNumColumn, instrNum);
+      AppendRaw(kIpColumn, ip);
+      AppendRaw(kTargetColumn, target);
+      AppendRaw(kFlagsColumn, flags);
+    } else {
+      AppendVarint(kInstrNumColumn,
+                   static_cast<std::uint64_t>(instrNum - lastInstrNum_));
+      AppendVarint(kIpColumn, ZigZag(ip - lastIp_));
+      AppendVarint(kTargetColumn, ZigZag(target - ip));
+      if (numBranches_ % 2 == 0) {
+        columns_[kFlagsColumn].push_back(flags & 0xF);
+      } else {
+        columns_[kFlagsColumn].back() |= (flags & 0xF) << 4;
+      }
+    }
+    lastInstrNum_ = instrNum;
+    lastIp_ = ip;
+    numBranches_ += 1;
+  }
+
+  // Returns false if the file could not be written.
+  bool Save(const std::string& path, std::int64_t numInstructions,
+            std::int64_t lastInstrRead) {
+    if (encoding_ == ColumnarEncoding::kRaw) {
+      AppendRaw(kInstrNumColumn, kEndOfTrace);
+      AppendRaw(kIpColumn, std::uint64_t{0});
+      AppendRaw(kTargetColumn, std::uint64_t{0});
+      AppendRaw(kFlagsColumn, std::uint8_t{0});
+    }
+    ColumnarTraceHeader header = {};
+    std::memcpy(header.magic, kColumnarTraceMagic, sizeof(header.magic));
+    header.version = kColumnarTraceVersion;
+    header.byteOrderMark = kColumnarTraceByteOrderMark;
+    header.encoding = encoding_;
+    header.numBranches = numBranches_;
+    header.numInstructions = numInstructions;
+    header.lastInstrRead = lastInstrRead;
+    std::uint64_t offset = sizeof(header);
+    for (int c = 0; c < kNumColumns; ++c) {
+      header.columnOffsets[c] = offset;
+      header.columnSizes[c] = columns_[c].size();
+      offset += Padded(columns_[c].size());
+    }
+    header.fileSize = offset;
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+      return false;
+    }
+    static const char kPadding[kColumnarTraceAlignment] = {};
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int c = 0; c < kNumColumns && written; ++c) {
+      std::size_t padding = Padded(columns_[c].size()) - columns_[c].size();
+      written = std::fwrite(columns_[c].data(), 1, columns_[c].size(),
+                            file) == columns_[c].size() &&
+                std::fwrite(kPadding, 1, padding, file) == padding;
+    }
+    return std::fclose(file) == 0 && written;
+  }
+
+ private:
+  static std::uint64_t ZigZag(std::uint64_t delta) {
+    return (delta << 1) ^ (0 - (delta >> 63));
+  }
+
+  static std::size_t Padded(std::size_t size) {
+    return (size + kColumnarTraceAlignment - 1) / kColumnarTraceAlignment *
+           kColumnarTraceAlignment;
+  }
+
+  template <class T>
+  void AppendRaw(int column, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    columns_[column].insert(columns_[column].end(), bytes,
+                            bytes + sizeof(value));
+  }
+
+  void AppendVarint(int column, std::uint64_t value) {
+    while (value >= 0x80) {
+      columns_[column].push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    columns_[column].push_back(static_cast<char>(value));
+  }
+
+  const ColumnarEncoding encoding_;
+  std::vector<char> columns_[kNumColumns];
+  std::uint64_t numBranches_ = 0;
+  std::int64_t lastInstrNum_ = 0;
+  std::uint64_t lastIp_ = 0;
+};
+
+// A mapped columnar trace. Throws std::runtime_error if the file cannot be
+// mapped or is not a valid columnar trace of this version and byte order.
+class ColumnarTrace {
+ public:
+  explicit ColumnarTrace(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("cannot open " + path);
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 &&
+        fileStat.st_size >= static_cast<off_t>(sizeof(ColumnarTraceHeader))) {
+      void* mapping =
+          mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping != MAP_FAILED) {
+        data_ = static_cast<const char*>(mapping);
+        size_ = fileStat.st_size;
+        madvise(mapping, size_, MADV_SEQUENTIAL);
+      }
+    }
+    close(fd);
+    if (!data_ || !Validate()) {
+      Unmap();
+      throw std::runtime_error(path + " is not a valid columnar trace");
+    }
+  }
+
+  ~ColumnarTrace() { Unmap(); }
+
+  ColumnarTrace(const ColumnarTrace&) = delete;
+  ColumnarTrace& operator=(const ColumnarTrace&) = delete;
+
+  // True if path starts with the magic of a columnar trace.
+  static bool IsColumnarTrace(const std::string& path) {
+    char magic[sizeof(kColumnarTraceMagic)] = {};
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+      return false;
+    }
+    bool read = std::fread(magic, sizeof(magic), 1, file) == 1;
+    std::fclose(file);
+    return read && std::memcmp(magic, kColumnarTraceMagic, sizeof(magic)) == 0;
+  }
+
+  const ColumnarTraceHeader& header() const { return header_; }
+
+  // The columns of a raw trace, with numBranches + 1 elements.
+  const std::int64_t* instrNums() const {
+    return Column<std::int64_t>(kInstrNumColumn);
+  }
+  const std::uint64_t* ips() const { return Column<std::uint64_t>(kIpColumn); }
+  const std::uint64_t* targets() const {
+    return Column<std::uint64_t>(kTargetColumn);
+  }
+  const std::uint8_t* flags() const {
+    return Column<std::uint8_t>(kFlagsColumn);
+  }
+
+  // Decodes the branches of a packed trace in order, followed by the
+  // sentinel.
+  class Decoder {
+   public:
+    explicit Decoder(const ColumnarTrace& trace) : trace_(trace) {
+      for (int c = 0; c < kNumColumns; ++c) {
+        positions_[c] = trace.Column<std::uint8_t>(c);
+      }
+    }
+
+    void Next(std::int64_t* instrNum, std::uint64_t* ip, std::uint64_t* target,
+              std::uint8_t* flags) {
+      if (index_ == trace_.header().numBranches) {
+        *instrNum = kEndOfTrace;
+        *ip = 0;
+        *target = 0;
+        *flags = 0;
+        return;
+      }
+      instrNum_ += static_cast<std::int64_t>(Varint(kInstrNumColumn));
+      ip_ += UnZigZag(Varint(kIpColumn));
+      *instrNum = instrNum_;
+      *ip = ip_;
+      *target = ip_ + UnZigZag(Varint(kTargetColumn));
+      std::uint8_t packedFlags = *positions_[kFlagsColumn];
+      if (index_ % 2 == 0) {
+        *flags = packedFlags & 0xF;
+      } else {
+        *flags = packedFlags >> 4;
+        positions_[kFlagsColumn] += 1;
+      }
+      index_ += 1;
+    }
+
+    // Number of branches decoded, without the sentinel.
+    std::uint64_t index() const { return index_; }
+
+   private:
+    static std::uint64_t UnZigZag(std::uint64_t value) {
+      return (value >> 1) ^ (0 - (value & 1));
+    }
+
+    // Validate() checks that every varint ends inside its column.
+    std::uint64_t Varint(int column) {
+      const std::uint8_t*& position = positions_[column];
+      std::uint64_t value = 0;
+      for (int shift = 0;; shift += 7) {
+        std::uint8_t byte = *position++;
+        if (shift < 64) {
+          value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        }
+        if (byte < 0x80) return value;
+      }
+    }
+
+    const ColumnarTrace& trace_;
+    const std::uint8_t* positions_[kNumColumns];
+    std::uint64_t index_ = 0;
+    std::int64_t instrNum_ = 0;
+    std::uint64_t ip_ = 0;
+  };
+
+ private:
+  void Unmap() {
+    if (data_) {
+      munmap(const_cast<char*>(data_), size_);
+      data_ = nullptr;
+    }
+  }
+
+  template <class T>
+  const T* Column(int column) const {
+    return reinterpret_cast<const T*>(data_ + header_.columnOffsets[column]);
+  }
+
+  bool Validate() {
+    std::memcpy(&header_, data_, sizeof(header_));
+    if (std::memcmp(header_.magic, kColumnarTraceMagic,
+                    sizeof(header_.magic)) ||
+        header_.version != kColumnarTraceVersion ||
+        header_.byteOrderMark != kColumnarTraceByteOrderMark ||
+        header_.fileSize != size_ ||
+        header_.numBranches >= size_) {
+      return false;
+    }
+    for (int c = 0; c < kNumColumns; ++c) {
+      if (header_.columnOffsets[c] % kColumnarTraceAlignment != 0 ||
+          header_.columnOffsets[c] > size_ ||
+          header_.columnSizes[c] > size_ - header_.columnOffsets[c]) {
+        return false;
+      }
+    }
+    if (header_.encoding == ColumnarEncoding::kRaw) {
+      const std::uint64_t numRows = header_.numBranches + 1;
+      const std::uint64_t elementSizes[kNumColumns] = {8, 8, 8, 1};
+      for (int c = 0; c < kNumColumns; ++c) {
+        if (header_.columnSizes[c] != numRows * elementSizes[c]) {
+          return false;
+        }
+      }
+      return instrNums()[header_.numBranches] == kEndOfTrace;
+    }
+    if (header_.encoding != ColumnarEncoding::kPacked ||
+        header_.columnSizes[kFlagsColumn] != (header_.numBranches + 1) / 2) {
+      return false;
+    }
+    // Each varint column holds exactly numBranches varints.
+    for (int c : {kInstrNumColumn, kIpColumn, kTargetColumn}) {
+      const std::uint8_t* bytes = Column<std::uint8_t>(c);
+      std::uint64_t numVarints = 0;
+      for (std::uint64_t i = 0; i < header_.columnSizes[c]; ++i) {
+        numVarints += bytes[i] < 0x80;
+      }
+      if (numVarints != header_.numBranches ||
+          (header_.columnSizes[c] > 0 &&
+           bytes[header_.columnSizes[c] - 1] >= 0x80)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+  ColumnarTraceHeader header_;
+};
+
+#endif  // SPEC_TAGE_SC_L_TEST_SBBT_COLUMNAR_TRACE_HPP_
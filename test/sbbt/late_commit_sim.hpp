@@ -0,0 +1,511 @@
+#ifndef SPEC_TAGE_SC_L_TEST_SBBT_LATE_COMMIT_SIM_HPP_
+#define SPEC_TAGE_SC_L_TEST_SBBT_LATE_COMMIT_SIM_HPP_
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <mbp/sim/simulator.hpp>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "branch_source.hpp"
+#include "spsc_ring.hpp"
+#include "tagescl/synthetic_stream.hpp"
+#include "tagescl/tagescl.hpp"
+
+// A simulation of a pipeline that commits a branch numCorrectPathInstrs
+// instructions after fetching it, and that fetches numWrongPathBranches
+// synthetic branches after every misprediction before flushing them.
+struct LateCommitParams {
+  std::string tracepath;
+  std::int64_t warmupInstrs;
+  std::int64_t simInstr;
+  std::int64_t stopAtInstr;
+  int numCorrectPathInstrs;
+  int numWrongPathBranches;
+};
+
+// Version of the reports of the late-commit simulators, and of the outputs
+// that gather them.
+constexpr char kLateCommitSimVersion[] = "v0.3.0";
+
+// Seed of the synthetic stream the wrong-path branches are taken from. Up to
+// v0.1.0 of the simulator they were made with std::rand() seeded with 1000,
+// so the reports of older versions are not comparable.
+constexpr std::uint64_t kWrongPathSeed = 1000;
+
+// Number of branches the predictor needs to keep in flight.
+inline int MaxInFlightBranches(int numCorrectPathInstrs,
+                               int numWrongPathBranches) {
+  return numCorrectPathInstrs + 1 + numWrongPathBranches;
+}
+
+struct RobEntry {
+  std::uint32_t bId;
+  std::int64_t instrNum;
+  std::uint64_t ip;
+  std::uint64_t target;
+  std::uint8_t flags;
+};
+
+constexpr tagescl::Branch_Type Type(std::uint8_t flags) {
+  tagescl::Branch_Type type{};
+  type.is_conditional = flags & kBranchConditional;
+  type.is_indirect = flags & kBranchIndirect;
+  return type;
+}
+
+// A pipeline of any predictor configuration, run one batch of the trace at a
+// time.
+class LateCommitPipelineBase {
+ public:
+  virtual ~LateCommitPipelineBase() = default;
+
+  // Processes branches until one reaches stopAtInstr. Returns false if it
+  // did.
+  virtual bool Run(const BranchBatch& batch, std::int64_t stopAtInstr) = 0;
+
+  virtual int numCorrectPathInstrs() const = 0;
+  virtual int numWrongPathBranches() const = 0;
+  virtual std::int64_t commitDistance() const = 0;
+  virtual std::int64_t numBranches() const = 0;
+  virtual std::int64_t mispredictions() const = 0;
+  // Empty unless the configuration collects statistics (see
+  // tagescl::With_Statistics).
+  virtual std::vector<tagescl::Statistic> predictorStatistics() const = 0;
+  // Only used by configurations that profile latencies (see
+  // tagescl::With_Latency_Profiling).
+  virtual void SetLatencySamplePeriod(std::uint32_t period) = 0;
+};
+
+// The predictor and the reorder buffer of one simulated pipeline. For every
+// branch of the trace, Commit() retires the branches that are old enough and
+// then Fetch() predicts the new one.
+template <class CONFIG>
+class LateCommitPipeline final : public LateCommitPipelineBase {
+ public:
+  LateCommitPipeline(int numCorrectPathInstrs, int numWrongPathBranches,
+                     std::int64_t warmupInstrs)
+      : bp_(std::make_unique<tagescl::Tage_SC_L<CONFIG>>(
+            MaxInFlightBranches(numCorrectPathInstrs, numWrongPathBranches))),
+        numCorrectPathInstrs_(numCorrectPathInstrs),
+        numWrongPathBranches_(numWrongPathBranches),
+        commitDistance_(numCorrectPathInstrs + 1),
+        warmupInstrs_(warmupInstrs),
+        rob_(1 + MaxInFlightBranches(numCorrectPathInstrs,
+                                     numWrongPathBranches)),
+        wrongPath_(WrongPathConfig()) {}
+
+  // Retires the branches that are at least commitDistance_ instructions
+  // older than instrNum, or all of them after a misprediction.
+  void Commit(std::int64_t instrNum) {
+    while (front_ != back_ &&
+           (mispredicted_ ||
+            instrNum - rob_[front_].instrNum >= commitDistance_)) {
+      const auto& r = rob_[front_];
+      bool taken = r.flags & kBranchTaken;
+      if (r.flags & kBranchConditional) {
+        bp_->commit_state(r.bId, r.ip, Type(r.flags), taken);
+      }
+      bp_->commit_state_at_retire(r.bId, r.ip, Type(r.flags), taken, r.target);
+      front_ = front_ + 1 < rob_.size() ? front_ + 1 : 0;
+    }
+  }
+
+  void Fetch(std::int64_t instrNum, std::uint64_t ip, std::uint64_t target,
+             std::uint8_t flags) {
+    // The statistics, like the metrics, leave out the warmup.
+    if ((CONFIG::COLLECT_STATISTICS || CONFIG::PROFILE_LATENCIES) &&
+        !warmedUp_ && instrNum >= warmupInstrs_) {
+      bp_->reset_statistics();
+      warmedUp_ = true;
+    }
+    std::uint32_t bId = bp_->get_new_branch_id();
+    rob_[back_] = {bId, instrNum, ip, target, flags};
+    back_ = back_ + 1 < rob_.size() ? back_ + 1 : 0;
+    bool prediction = bp_->get_prediction(bId, ip);
+    bool taken = flags & kBranchTaken;
+    if (flags & kBranchConditional) {
+      mispredicted_ = prediction != taken;
+      bp_->update_speculative_state(bId, ip, Type(flags), prediction, target);
+      if (mispredicted_) {
+        FetchWrongPath(ip);
+        bp_->flush_branch_and_repair_state(bId, ip, Type(flags), taken,
+                                           target);
+      }
+      if (instrNum >= warmupInstrs_) {
+        numBranches_ += 1;
+        mispredictions_ += mispredicted_;
+      }
+    } else {
+      bp_->update_speculative_state(bId, ip, Type(flags), taken, target);
+    }
+  }
+
+  bool Run(const BranchBatch& batch, std::int64_t stopAtInstr) override {
+    for (std::size_t i = 0; i < batch.size; ++i) {
+      std::int64_t instrNum = batch.instrNums[i];
+      Commit(instrNum);
+      if (instrNum >= stopAtInstr) return false;
+      Fetch(instrNum, batch.ips[i], batch.targets[i], batch.flags[i]);
+    }
+    return true;
+  }
+
+  int numCorrectPathInstrs() const override { return numCorrectPathInstrs_; }
+  int numWrongPathBranches() const override { return numWrongPathBranches_; }
+  std::int64_t commitDistance() const override { return commitDistance_; }
+  std::int64_t numBranches() const override { return numBranches_; }
+  std::int64_t mispredictions() const override { return mispredictions_; }
+  std::vector<tagescl::Statistic> predictorStatistics() const override {
+    return bp_->get_statistics();
+  }
+  void SetLatencySamplePeriod(std::uint32_t period) override {
+    bp_->set_latency_sample_period(period);
+  }
+
+ private:
+  // Wrong-path branches are taken from a synthetic stream and placed after
+  // the mispredicted branch.
+  static tagescl::Synthetic_Stream_Config WrongPathConfig() {
+    tagescl::Synthetic_Stream_Config config;
+    config.seed = kWrongPathSeed;
+    return config;
+  }
+
+  void FetchWrongPath(std::uint64_t ip) {
+    for (int i = 0; i < numWrongPathBranches_; ++i) {
+      tagescl::Branch_Record wp = wrongPath_.next();
+      std::uint64_t wpIp = ip + wp.br_pc;
+      std::uint64_t wpTgt = ip + wp.br_target;
+      std::uint32_t wpId = bp_->get_new_branch_id();
+      bool wpPred = bp_->get_prediction(wpId, wpIp);
+      bp_->update_speculative_state(
+          wpId, wpIp, wp.br_type,
+          wp.br_type.is_conditional ? wpPred : wp.resolve_dir, wpTgt);
+    }
+  }
+
+  std::unique_ptr<tagescl::Tage_SC_L<CONFIG>> bp_;
+  const int numCorrectPathInstrs_;
+  const int numWrongPathBranches_;
+  const std::int64_t commitDistance_;
+  const std::int64_t warmupInstrs_;
+  std::vector<RobEntry> rob_;
+  std::size_t front_ = 0;
+  std::size_t back_ = 0;
+  bool mispredicted_ = false;
+  tagescl::Synthetic_Branch_Stream wrongPath_;
+  std::int64_t numBranches_ = 0;
+  std::int64_t mispredictions_ = 0;
+  bool warmedUp_ = false;
+};
+
+// The statistics of a predictor as nested objects, split at the slashes of
+// their names. The buckets of a histogram become an array.
+inline mbp::json StatisticsJson(
+    const std::vector<tagescl::Statistic>& statistics) {
+  mbp::json j = mbp::json::object();
+  for (const auto& [name, value] : statistics) {
+    j[mbp::json::json_pointer("/" + name)] = value;
+  }
+  return j;
+}
+
+// The report of one pipeline, in the format of the other SBBT simulators.
+// simulationTime is the time spent running this pipeline.
+inline mbp::json LateCommitReport(const LateCommitPipelineBase& pipeline,
+                                  const LateCommitParams& params,
+                                  const TraceSummary& trace,
+                                  double simulationTime) {
+  const auto& [tracepath, warmupInstrs, simInstr, stopAtInstr,
+               numCorrectPathInstrs, numWrongPathBranches] = params;
+  std::int64_t numBranches = pipeline.numBranches();
+  std::int64_t mispredictions = pipeline.mispredictions();
+  std::vector<std::string> errors;
+  // See Note 0.
+  std::int64_t metricInstr =
+      simInstr == 0 ? trace.numInstructions - warmupInstrs : simInstr;
+  if (simInstr != 0 && trace.eof) {
+    std::string errMsg = "The trace did not contain " +
+                         std::to_string(simInstr) + " instructions, only " +
+                         std::to_string(trace.lastInstrRead);
+    errors.emplace_back(errMsg);
+  }
+
+  mbp::json j = {
+      {"metadata",
+       {
+           {"simulator", "SBBT trace with late commit and wrong path."},
+           {"simulator_version", kLateCommitSimVersion},
+           {"simulator_num_correct_path_instrs", pipeline.commitDistance()},
+           {"simulator_num_wrong_path_branches",
+            pipeline.numWrongPathBranches()},
+           {"simulator_wrong_path_stream",
+            "tagescl::Synthetic_Branch_Stream, seed " +
+                std::to_string(kWrongPathSeed)},
+           {"trace", tracepath},
+           {"warmup_instr", warmupInstrs},
+           {"simulation_instr", metricInstr},
+           {"exhausted_trace", trace.eof},
+           {"num_conditonal_branches", numBranches},
+           {"num_branch_instructions", trace.numBranchIps},
+           {"predictor", {{"name", "Adapter of Scarab's TAGE-SC-L to MBPlib"}}},
+       }},
+      {"metrics",
+       {
+           {"mpki", 1000.0 * mispredictions / metricInstr},
+           {"mispredictions", mispredictions},
+           {"accuracy",
+            static_cast<double>(numBranches - mispredictions) / numBranches},
+           {"simulation_time", simulationTime},
+       }},
+      {"predictor_statistics",
+       StatisticsJson(pipeline.predictorStatistics())},
+      {"errors", errors},
+  };
+  return j;
+}
+
+// Simulates a new pipeline on the trace, in the calling thread. The pipeline
+// must have been made with the parameters of params.
+inline mbp::json LateCommitSim(LateCommitPipelineBase& pipeline,
+                               const LateCommitParams& params) {
+  constexpr std::size_t kBatchSize = 1 << 12;
+  std::unique_ptr<BranchSource> trace =
+      OpenBranchSource(params.tracepath, params.stopAtInstr);
+  BranchBlock block;
+  auto startTime = std::chrono::high_resolution_clock::now();
+  for (BranchBatch batch = trace->Next(kBatchSize, &block); batch.size > 0;
+       batch = trace->Next(kBatchSize, &block)) {
+    pipeline.Run(batch, params.stopAtInstr);
+  }
+  auto endTime = std::chrono::high_resolution_clock::now();
+  double simulationTime =
+      std::chrono::duration<double>(endTime - startTime).count();
+  return LateCommitReport(pipeline, params, trace->Summary(), simulationTime);
+}
+
+using LateCommitFactory = std::unique_ptr<LateCommitPipelineBase> (*)(
+    int numCorrectPathInstrs, int numWrongPathBranches,
+    std::int64_t warmupInstrs);
+
+template <class CONFIG>
+std::unique_ptr<LateCommitPipelineBase> MakeLateCommitPipeline(
+    int numCorrectPathInstrs, int numWrongPathBranches,
+    std::int64_t warmupInstrs) {
+  return std::make_unique<LateCommitPipeline<CONFIG>>(
+      numCorrectPathInstrs, numWrongPathBranches, warmupInstrs);
+}
+
+// The predictor configurations a sweep can use, by name. Add custom
+// configurations here. They checkpoint the folded histories, since the wrong
+// path makes recoveries frequent. The "+stats" and "+latency" variants make
+// the same predictions and fill "predictor_statistics" in the reports with
+// the counters of the components or with the latencies of the predictor
+// calls.
+template <class CONFIG>
+using LateCommitConfig = tagescl::With_Folded_History_Checkpoints<CONFIG>;
+
+inline const std::map<std::string, LateCommitFactory>& LateCommitConfigs() {
+  using tagescl::CONFIG_64KB;
+  using tagescl::CONFIG_80KB;
+  using tagescl::With_Latency_Profiling;
+  using tagescl::With_Statistics;
+  static const std::map<std::string, LateCommitFactory> configs = {
+      {"64KB", MakeLateCommitPipeline<LateCommitConfig<CONFIG_64KB>>},
+      {"80KB", MakeLateCommitPipeline<LateCommitConfig<CONFIG_80KB>>},
+      {"64KB+stats",
+       MakeLateCommitPipeline<With_Statistics<LateCommitConfig<CONFIG_64KB>>>},
+      {"80KB+stats",
+       MakeLateCommitPipeline<With_Statistics<LateCommitConfig<CONFIG_80KB>>>},
+      {"64KB+latency",
+       MakeLateCommitPipeline<
+           With_Latency_Profiling<LateCommitConfig<CONFIG_64KB>>>},
+      {"80KB+latency",
+       MakeLateCommitPipeline<
+           With_Latency_Profiling<LateCommitConfig<CONFIG_80KB>>>},
+  };
+  return configs;
+}
+
+// The CPUs this process may run on.
+inline std::vector<int> AllowedCpus() {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+inline void PinCurrentThread(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// A pipeline of a sweep: a configuration of LateCommitConfigs() and the
+// pipeline parameters.
+struct SweepJob {
+  std::string config;
+  int numCorrectPathInstrs;
+  int numWrongPathBranches;
+};
+
+struct SweepOptions {
+  int numThreads = 1;
+  // Branches the decoder can run ahead of the predictors, rounded up to
+  // whole batches. When the ring is full, the decoder waits.
+  std::size_t ringCapacity = 1 << 16;
+  // Maximum number of branches run in one lock-step round.
+  std::size_t batchSize = 1 << 12;
+  // One in this many branches has its predictor calls timed, in the
+  // configurations that profile latencies.
+  std::uint32_t latencySamplePeriod = 64;
+};
+
+// A batch in the ring of LateCommitSweep(), and the storage of its branches
+// if they had to be decoded.
+struct BatchSlot {
+  BranchBatch batch;
+  BranchBlock block;
+};
+
+struct SweepResult {
+  // The report of each job, in order.
+  std::vector<mbp::json> reports;
+  // Time of the whole sweep, from decoding the first batch to finishing the
+  // last pipeline.
+  double wallTime;
+};
+
+// Simulates every job of a sweep in a single pass over the trace. A producer
+// thread reads the trace once into an SpscRing of batches, which all the
+// pipelines read in place; batches of raw columnar traces point into the
+// mapped file. The pipelines are split among options.numThreads worker
+// threads, pinned round-robin to the allowed CPUs, which build their own
+// predictors and run each batch in lock step. The report of each job has the
+// configuration name in its metadata, and the time spent in that pipeline
+// alone as its simulation_time. The pipeline parameters in params are
+// ignored.
+inline SweepResult LateCommitSweep(const LateCommitParams& params,
+                                   const std::vector<SweepJob>& jobs,
+                                   const SweepOptions& options) {
+  const int numThreads =
+      std::max(1, std::min<int>(options.numThreads, jobs.size()));
+  const std::size_t batchSize = std::max<std::size_t>(options.batchSize, 1);
+  std::vector<std::unique_ptr<LateCommitPipelineBase>> pipelines(jobs.size());
+  std::vector<double> runTimes(jobs.size());
+  std::vector<int> cpus = AllowedCpus();
+
+  std::unique_ptr<BranchSource> trace =
+      OpenBranchSource(params.tracepath, params.stopAtInstr);
+  SpscRing<BatchSlot> ring((options.ringCapacity + batchSize - 1) /
+                           batchSize);
+  auto producer = [&] {
+    while (true) {
+      ring.WaitForSpace();
+      BatchSlot* slot = ring.Back();
+      slot->batch = trace->Next(batchSize, &slot->block);
+      if (slot->batch.size == 0) break;
+      ring.Publish(1);
+    }
+    ring.Close();
+  };
+
+  // The workers run the batch when round changes, and decrement running when
+  // done. An empty batch stops them.
+  BranchBatch batch;
+  std::mutex mutex;
+  std::condition_variable roundStarted;
+  std::condition_variable roundDone;
+  int round = 0;
+  int running = 0;
+  auto worker = [&](int threadId) {
+    if (!cpus.empty()) {
+      PinCurrentThread(cpus[threadId % cpus.size()]);
+    }
+    for (std::size_t i = threadId; i < jobs.size(); i += numThreads) {
+      pipelines[i] = LateCommitConfigs().at(jobs[i].config)(
+          jobs[i].numCorrectPathInstrs, jobs[i].numWrongPathBranches,
+          params.warmupInstrs);
+      pipelines[i]->SetLatencySamplePeriod(options.latencySamplePeriod);
+    }
+    for (int seen = 0;; ++seen) {
+      BranchBatch branches;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        roundStarted.wait(lock, [&] { return round != seen; });
+        branches = batch;
+      }
+      if (branches.size == 0) return;
+      for (std::size_t i = threadId; i < jobs.size(); i += numThreads) {
+        auto runStart = std::chrono::high_resolution_clock::now();
+        pipelines[i]->Run(branches, params.stopAtInstr);
+        auto runEnd = std::chrono::high_resolution_clock::now();
+        runTimes[i] += std::chrono::duration<double>(runEnd - runStart).count();
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--running == 0) {
+        roundDone.notify_one();
+      }
+    }
+  };
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+  std::thread decoder(producer);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; ++t) {
+    threads.emplace_back(worker, t);
+  }
+  while (true) {
+    bool done = ring.WaitForData() == 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      batch = done ? BranchBatch() : ring.Front()->batch;
+      running = numThreads;
+      ++round;
+    }
+    roundStarted.notify_all();
+    if (done) break;
+    std::unique_lock<std::mutex> lock(mutex);
+    roundDone.wait(lock, [&] { return running == 0; });
+    lock.unlock();
+    ring.Release(1);
+  }
+  decoder.join();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto endTime = std::chrono::high_resolution_clock::now();
+
+  SweepResult result;
+  result.wallTime = std::chrono::duration<double>(endTime - startTime).count();
+  for (std::size_t i = 0; i < jobs.size(); ++i) {
+    LateCommitParams jobParams = params;
+    jobParams.numCorrectPathInstrs = jobs[i].numCorrectPathInstrs;
+    jobParams.numWrongPathBranches = jobs[i].numWrongPathBranches;
+    result.reports.push_back(LateCommitReport(*pipelines[i], jobParams,
+                                              trace->Summary(), runTimes[i]));
+    result.reports.back()["metadata"]["config"] = jobs[i].config;
+  }
+  return result;
+}
+
+#endif  // SPEC_TAGE_SC_L_TEST_SBBT_LATE_COMMIT_SIM_HPP_
@@ -3,13 +3,20 @@
 #include "tagescl/ifaces/mbplib/tage_sc_l_sim_only.hpp"
 
 #if TAGE_SC_L_SIZE == 64
-static tagescl::MbpTageScl<tagescl::CONFIG_64KB> branchPredictor(1);
+using Config = tagescl::CONFIG_64KB;
 #elif TAGE_SC_L_SIZE == 80
-static tagescl::MbpTageScl<tagescl::CONFIG_80KB> branchPredictor(1);
+using Config = tagescl::CONFIG_80KB;
 #else
 #error Unsupported TAGE_SC_L_SIZE setting.
 #endif
 
+// Define TAGE_SC_L_STATISTICS to report the predictor statistics.
+#ifdef TAGE_SC_L_STATISTICS
+static tagescl::MbpTageScl<tagescl::With_Statistics<Config>> branchPredictor(1);
+#else
+static tagescl::MbpTageScl<Config> branchPredictor(1);
+#endif
+
 int main(int argc, char** argv) {
   return mbp::SimMain(argc, argv, &branchPredictor);
 }
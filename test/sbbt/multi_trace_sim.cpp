@@ -0,0 +1,241 @@
+// Runs every combination of traces, predictor configurations and pipeline
+// parameters of the command line as independent jobs on a pool of threads,
+// and prints one JSON report with the output of every job, in job order.
+//
+// Usage: multi_trace_sim [options] TRACE...
+//   -j, --threads N        Number of worker threads (default: one per CPU).
+//   -c, --config NAME      Predictor configuration, 64KB or 80KB, or
+//                          64KB+stats or 80KB+stats to also report the
+//                          predictor statistics, or 64KB+latency or
+//                          80KB+latency to also report the latencies of the
+//                          predictor calls. Can be repeated (default: 64KB).
+//   -p, --pipeline C:W     Correct-path instructions before commit and
+//                          wrong-path branches per misprediction, as in
+//                          wrong_path_sim. Can be repeated (default: 0:0).
+//   -w, --warmup-instr N   Instructions to warm up the predictor.
+//   -s, --sim-instr N      Instructions to simulate after the warmup (default:
+//                          until the end of the trace).
+//   -l, --trace-list FILE  Reads more traces from FILE, one per line.
+//   --latency-sample-period N
+//                          Time the predictor calls of one in N branches in
+//                          the +latency configurations (default: 64).
+//
+// Each worker thread is pinned to one of the CPUs the process may run on, and
+// allocates the predictors of its jobs itself, so that with a first-touch
+// memory policy the tables live in the NUMA node of the thread using them.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mbp/sim/simulator.hpp>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "late_commit_sim.hpp"
+#include "tagescl/tagescl.hpp"
+
+namespace {
+
+struct Job {
+  std::string tracepath;
+  std::string config;
+  int numCorrectPathInstrs;
+  int numWrongPathBranches;
+};
+
+struct Options {
+  int numThreads = 0;
+  std::vector<std::string> configs;
+  std::vector<std::pair<int, int>> pipelines;
+  std::int64_t warmupInstrs = 0;
+  std::int64_t simInstr = 0;
+  std::vector<std::string> traces;
+  std::uint32_t latencySamplePeriod = 64;
+};
+
+// The predictor is allocated by the thread that runs the job. The
+// configurations are those of LateCommitConfigs(), as in wrong_path_sim.
+mbp::json RunJob(const Job& job, const Options& options) {
+  std::int64_t stopAtInstr = options.simInstr == 0
+                                 ? std::numeric_limits<std::int64_t>::max()
+                                 : options.warmupInstrs + options.simInstr;
+  std::unique_ptr<LateCommitPipelineBase> pipeline =
+      LateCommitConfigs().at(job.config)(job.numCorrectPathInstrs,
+                                         job.numWrongPathBranches,
+                                         options.warmupInstrs);
+  pipeline->SetLatencySamplePeriod(options.latencySamplePeriod);
+  return LateCommitSim(*pipeline, {job.tracepath, options.warmupInstrs,
+                                   options.simInstr, stopAtInstr,
+                                   job.numCorrectPathInstrs,
+                                   job.numWrongPathBranches});
+}
+
+[[noreturn]] void Usage(const std::string& error) {
+  std::cerr << "multi_trace_sim: " << error << "\n"
+            << "Usage: multi_trace_sim [-j threads] "
+               "[-c 64KB|80KB|64KB+stats|80KB+stats|64KB+latency|"
+               "80KB+latency]... "
+               "[-p correct_path_instrs:wrong_path_branches]... "
+               "[-w warmup_instr] [-s sim_instr] [-l trace_list] "
+               "[--latency-sample-period N] TRACE...\n";
+  std::exit(mbp::ERR_SIMULATION_ERROR);
+}
+
+std::int64_t ParseInt(const std::string& text, const std::string& option) {
+  char* end = nullptr;
+  long long value = std::strtoll(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || value < 0) {
+    Usage("invalid value '" + text + "' for " + option);
+  }
+  return value;
+}
+
+Options ParseArgs(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.empty() || arg[0] != '-') {
+      options.traces.push_back(arg);
+      continue;
+    }
+    if (i + 1 == argc) {
+      Usage("missing value for " + arg);
+    }
+    std::string value = argv[++i];
+    if (arg == "-j" || arg == "--threads") {
+      options.numThreads = static_cast<int>(ParseInt(value, arg));
+    } else if (arg == "-c" || arg == "--config") {
+      if (LateCommitConfigs().count(value) == 0) {
+        Usage("unknown configuration " + value);
+      }
+      options.configs.push_back(value);
+    } else if (arg == "-p" || arg == "--pipeline") {
+      std::size_t colon = value.find(':');
+      if (colon == std::string::npos) {
+        Usage("expected C:W for " + arg);
+      }
+      options.pipelines.emplace_back(
+          static_cast<int>(ParseInt(value.substr(0, colon), arg)),
+          static_cast<int>(ParseInt(value.substr(colon + 1), arg)));
+    } else if (arg == "-w" || arg == "--warmup-instr") {
+      options.warmupInstrs = ParseInt(value, arg);
+    } else if (arg == "-s" || arg == "--sim-instr") {
+      options.simInstr = ParseInt(value, arg);
+    } else if (arg == "--latency-sample-period") {
+      options.latencySamplePeriod =
+          std::max<std::int64_t>(1, ParseInt(value, arg));
+    } else if (arg == "-l" || arg == "--trace-list") {
+      std::ifstream list(value);
+      if (!list) {
+        Usage("cannot read " + value);
+      }
+      for (std::string line; std::getline(list, line);) {
+        if (!line.empty()) {
+          options.traces.push_back(line);
+        }
+      }
+    } else {
+      Usage("unknown option " + arg);
+    }
+  }
+  if (options.traces.empty()) {
+    Usage("no traces");
+  }
+  if (options.configs.empty()) {
+    options.configs.push_back("64KB");
+  }
+  if (options.pipelines.empty()) {
+    options.pipelines.emplace_back(0, 0);
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options = ParseArgs(argc, argv);
+  std::vector<Job> jobs;
+  for (const auto& trace : options.traces) {
+    for (const auto& config : options.configs) {
+      for (const auto& [correctPathInstrs, wrongPathBranches] :
+           options.pipelines) {
+        jobs.push_back({trace, config, correctPathInstrs, wrongPathBranches});
+      }
+    }
+  }
+
+  std::vector<int> cpus = AllowedCpus();
+  int numThreads = options.numThreads;
+  if (numThreads == 0) {
+    numThreads = cpus.empty()
+                     ? static_cast<int>(
+                           std::max(1u, std::thread::hardware_concurrency()))
+                     : static_cast<int>(cpus.size());
+  }
+  numThreads = std::min<int>(numThreads, jobs.size());
+
+  std::vector<mbp::json> results(jobs.size());
+  std::atomic<std::size_t> nextJob{0};
+  auto worker = [&](int threadId) {
+    if (!cpus.empty()) {
+      PinCurrentThread(cpus[threadId % cpus.size()]);
+    }
+    for (std::size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+      const Job& job = jobs[i];
+      try {
+        results[i] = RunJob(job, options);
+      } catch (const std::exception& e) {
+        results[i] = {{"errors", {std::string(e.what())}}};
+      }
+      results[i]["job"] = {
+          {"trace", job.tracepath},
+          {"config", job.config},
+          {"num_correct_path_instrs", job.numCorrectPathInstrs},
+          {"num_wrong_path_branches", job.numWrongPathBranches},
+      };
+    }
+  };
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; ++t) {
+    threads.emplace_back(worker, t);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto endTime = std::chrono::high_resolution_clock::now();
+
+  std::vector<std::string> errors;
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    for (const auto& error : results[i]["errors"]) {
+      errors.push_back("job " + std::to_string(i) + " (" +
+                       jobs[i].tracepath + "): " + error.get<std::string>());
+    }
+  }
+  mbp::json output = {
+      {"metadata",
+       {
+           {"simulator", "Multi-trace SBBT simulator with late commit and "
+                         "wrong path."},
+           {"simulator_version", kLateCommitSimVersion},
+           {"num_jobs", jobs.size()},
+           {"num_threads", numThreads},
+           {"wall_time",
+            std::chrono::duration<double>(endTime - startTime).count()},
+       }},
+      {"jobs", results},
+      {"errors", errors},
+  };
+  std::cout << std::setw(2) << output << std::endl;
+  return errors.empty() ? 0 : mbp::ERR_SIMULATION_ERROR;
+}
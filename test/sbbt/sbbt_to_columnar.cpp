@@ -0,0 +1,55 @@
+// Converts an SBBT trace into a columnar trace (see columnar_trace.hpp), which
+// wrong_path_sim and multi_trace_sim replay without decoding it again.
+//
+// Usage: sbbt_to_columnar [--packed] TRACE OUTPUT
+//   --packed  Delta and varint-encodes the columns. Packed traces are smaller
+//             but are decoded when replayed; raw ones are read in place.
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <mbp/sim/sbbt_reader.hpp>
+#include <mbp/sim/simulator.hpp>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "branch_source.hpp"
+#include "columnar_trace.hpp"
+
+int main(int argc, char** argv) {
+  std::vector<std::string> args(argv + 1, argv + argc);
+  ColumnarEncoding encoding = ColumnarEncoding::kRaw;
+  if (!args.empty() && args[0] == "--packed") {
+    encoding = ColumnarEncoding::kPacked;
+    args.erase(args.begin());
+  }
+  if (args.size() != 2) {
+    std::cerr << "Usage: sbbt_to_columnar [--packed] TRACE OUTPUT\n";
+    return mbp::ERR_SIMULATION_ERROR;
+  }
+
+  try {
+    mbp::SbbtReader trace{args[0]};
+    ColumnarTraceWriter writer(encoding);
+    std::unordered_set<std::uint64_t> branchIps;
+    mbp::Branch b;
+    for (std::int64_t instrNum = trace.nextBranch(b); instrNum != kEndOfTrace;
+         instrNum = trace.nextBranch(b)) {
+      std::uint8_t flags = BranchFlags(b);
+      if (branchIps.insert(b.ip()).second) {
+        flags |= kBranchNewIp;
+      }
+      writer.Add(instrNum, b.ip(), b.target(), flags);
+    }
+    if (!writer.Save(args[1], trace.numInstructions(),
+                     trace.lastInstrRead())) {
+      std::cerr << "sbbt_to_columnar: cannot write " << args[1] << "\n";
+      return mbp::ERR_SIMULATION_ERROR;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "sbbt_to_columnar: " << e.what() << "\n";
+    return mbp::ERR_SIMULATION_ERROR;
+  }
+  return 0;
+}
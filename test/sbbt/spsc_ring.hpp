@@ -0,0 +1,102 @@
+#ifndef SPEC_TAGE_SC_L_TEST_SBBT_SPSC_RING_HPP_
+#define SPEC_TAGE_SC_L_TEST_SBBT_SPSC_RING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// A lock-free ring buffer with one producer and one consumer thread. Both
+// sides work on contiguous spans of slots in place: the producer fills the
+// span returned by WaitForSpace() and publishes it, and the consumer reads the
+// span returned by WaitForData() and releases it. A full ring blocks the
+// producer, so the capacity bounds how far it runs ahead of the consumer.
+template <class T>
+class SpscRing {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit SpscRing(std::size_t capacity)
+      : capacity_(RoundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1))),
+        slots_(capacity_) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  std::size_t capacity() const { return capacity_; }
+
+  // Producer: waits until there is a free slot and returns the number of
+  // contiguous free slots starting at Back().
+  std::size_t WaitForSpace() {
+    for (int spins = 0; capacity_ == producerHead_ - cachedTail_; ++spins) {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+      if (capacity_ == producerHead_ - cachedTail_) Backoff(spins);
+    }
+    return std::min(capacity_ - (producerHead_ - cachedTail_),
+                    capacity_ - (producerHead_ & (capacity_ - 1)));
+  }
+
+  T* Back() { return &slots_[producerHead_ & (capacity_ - 1)]; }
+
+  // Producer: makes the first n slots at Back() visible to the consumer.
+  void Publish(std::size_t n) {
+    producerHead_ += n;
+    head_.store(producerHead_, std::memory_order_release);
+  }
+
+  // Producer: no more slots will be published.
+  void Close() { closed_.store(true, std::memory_order_release); }
+
+  // Consumer: waits until there is a published slot and returns the number of
+  // contiguous published slots starting at Front(), or 0 if the ring is
+  // closed and empty.
+  std::size_t WaitForData() {
+    for (int spins = 0; cachedHead_ == consumerTail_; ++spins) {
+      bool closed = closed_.load(std::memory_order_acquire);
+      cachedHead_ = head_.load(std::memory_order_acquire);
+      if (cachedHead_ != consumerTail_) break;
+      if (closed) return 0;
+      Backoff(spins);
+    }
+    return std::min(cachedHead_ - consumerTail_,
+                    capacity_ - (consumerTail_ & (capacity_ - 1)));
+  }
+
+  const T* Front() const { return &slots_[consumerTail_ & (capacity_ - 1)]; }
+
+  // Consumer: returns the first n slots at Front() to the producer.
+  void Release(std::size_t n) {
+    consumerTail_ += n;
+    tail_.store(consumerTail_, std::memory_order_release);
+  }
+
+ private:
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  static std::size_t RoundUpToPowerOfTwo(std::size_t n) {
+    std::size_t power = 1;
+    while (power < n) power <<= 1;
+    return power;
+  }
+
+  // Spins for a while, then yields the CPU to the other side.
+  static void Backoff(int spins) {
+    if (spins >= 64) std::this_thread::yield();
+  }
+
+  const std::size_t capacity_;
+  std::vector<T> slots_;
+
+  // The indices grow without wrapping; a slot is at index % capacity_. Each
+  // side keeps its own index and a cached copy of the other one in its own
+  // cache line.
+  alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+  std::atomic<bool> closed_{false};
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+  alignas(kCacheLineSize) std::size_t producerHead_ = 0;
+  std::size_t cachedTail_ = 0;
+  alignas(kCacheLineSize) std::size_t consumerTail_ = 0;
+  std::size_t cachedHead_ = 0;
+};
+
+#endif  // SPEC_TAGE_SC_L_TEST_SBBT_SPSC_RING_HPP_
@@ -1,168 +1,180 @@
-#include <cerrno>
-#include <chrono>
+// Simulates the predictor in a pipeline that commits branches late and fetches
+// wrong-path branches after mispredictions (see late_commit_sim.hpp).
+//
+// Usage: wrong_path_sim [--config NAME]... [--pipeline C:W]... [--threads N]
+//                       [--ring-capacity N] [--batch N]
+//                       [--latency-sample-period N] MBPLIB_ARGS...
+//   --config NAME   Predictor configuration, 64KB or 80KB, or 64KB+stats or
+//                   80KB+stats to also report the predictor statistics, or
+//                   64KB+latency or 80KB+latency to also report the latencies
+//                   of the predictor calls (default: 64KB).
+//   --pipeline C:W  Correct-path instructions before commit and wrong-path
+//                   branches per misprediction (default: 0:0).
+//   --threads N     Threads running the pipelines of a sweep (default: one
+//                   per pipeline, up to the number of CPUs).
+//   --ring-capacity N
+//                   Branches the trace decoder, which runs on its own thread,
+//                   can decode ahead of the predictors (default: 65536).
+//   --batch N       Branches the predictors run between synchronizations
+//                   (default: 4096).
+//   --latency-sample-period N
+//                   Time the predictor calls of one in N branches in the
+//                   +latency configurations (default: 64).
+// The remaining arguments are parsed by MBPlib. The trace can be an SBBT trace
+// or a columnar trace made by sbbt_to_columnar.
+//
+// With more than one configuration or pipeline, every combination of them is
+// simulated in a single pass over the trace, and the output has the report of
+// each one in "sweep", with the configurations in the outer loop. The
+// simulation_time of a report is the time spent in its own pipeline, and the
+// wall_time of the sweep is the time of the whole pass.
+
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <exception>
 #include <iostream>
-#include <limits>
-#include <mbp/sim/sbbt_reader.hpp>
 #include <mbp/sim/simulator.hpp>
-#include <nlohmann/json.hpp>
 #include <string>
-#include <unordered_set>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#include "tagescl/tagescl.hpp"
-
-#ifndef NUM_CORRECT_PATH_INSTRS
-#error NUM_CORRECT_PATH_INSTRS not defined
-#endif
-#ifndef NUM_WRONG_PATH_BRANCHES
-#error NUM_WRONG_PATH_BRANCHES not defined
-#endif
-
-constexpr int kNumCorrectPathInstrs = NUM_CORRECT_PATH_INSTRS + 1;
-constexpr int kNumWrongPathBranches = NUM_WRONG_PATH_BRANCHES;
-
-static_assert(kNumCorrectPathInstrs >= 1,
-              "NUM_CORRECT_PATH_INSTRS shall be non-negative");
-static_assert(kNumWrongPathBranches >= 0,
-              "NUM_WRONG_PATH_BRANCHES shall be non-negative");
+#include "late_commit_sim.hpp"
 
-struct RobEntry {
-  std::uint32_t bId;
-  std::int64_t instrNum;
-  mbp::Branch b;
-};
+namespace {
 
-constexpr tagescl::Branch_Type Type(const mbp::Branch& b) {
-  tagescl::Branch_Type type{};
-  type.is_conditional = b.isConditional();
-  type.is_indirect = b.isIndirect();
-  return type;
+[[noreturn]] void Usage(const std::string& error) {
+  std::cerr << "wrong_path_sim: " << error << "\n"
+            << "Usage: wrong_path_sim "
+               "[--config 64KB|80KB|64KB+stats|80KB+stats|64KB+latency|"
+               "80KB+latency]... "
+               "[--pipeline correct_path_instrs:wrong_path_branches]... "
+               "[--threads N] [--ring-capacity N] [--batch N] "
+               "[--latency-sample-period N] "
+               "MBPLIB_ARGS...\n";
+  std::exit(mbp::ERR_SIMULATION_ERROR);
 }
 
-template <class CONFIG>
-mbp::json Sim(tagescl::Tage_SC_L<CONFIG>& bp, const mbp::SimArgs& args) {
-  const auto& [tracepath, warmupInstrs, simInstr, stopAtInstr] = args;
-  mbp::SbbtReader trace{tracepath};
-  struct BranchInfo {
-    std::int64_t occurrences, misses;
-  };
-  std::unordered_set<uint64_t> branchIps;
-  std::int64_t numBranches = 0;
-  std::int64_t mispredictions = 0;
-  std::vector<std::string> errors;
+int ParseInt(const std::string& text, const std::string& option) {
+  char* end = nullptr;
+  long value = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || value < 0) {
+    Usage("invalid value '" + text + "' for " + option);
+  }
+  return static_cast<int>(value);
+}
 
-  std::vector<RobEntry> rob(1 + kNumCorrectPathInstrs + kNumWrongPathBranches);
-  std::size_t front = 0;
-  std::size_t back = 0;
-  std::srand(1000);
-  auto startTime = std::chrono::high_resolution_clock::now();
-  mbp::Branch b;
-  bool mispredicted = false;
+}  // namespace
 
-  while (true) {
-    std::int64_t instrNum = trace.nextBranch(b);
-    while (front != back && (mispredicted || instrNum - rob[front].instrNum >=
-                                                 kNumCorrectPathInstrs)) {
-      const auto& r = rob[front];
-      if (r.b.isConditional()) {
-        bp.commit_state(r.bId, r.b.ip(), Type(r.b), r.b.isTaken());
-      }
-      bp.commit_state_at_retire(r.bId, r.b.ip(), Type(r.b), r.b.isTaken(),
-                                r.b.target());
-      front = front + 1 < rob.size() ? front + 1 : 0;
+int main(int argc, char** argv) {
+  // Removes the options of this driver and leaves the rest to MBPlib.
+  std::vector<std::string> configs;
+  std::vector<std::pair<int, int>> pipelines;
+  SweepOptions options;
+  options.numThreads = 0;
+  std::vector<char*> mbpArgv = {argv[0]};
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg != "--config" && arg != "--pipeline" && arg != "--threads" &&
+        arg != "--ring-capacity" && arg != "--batch" &&
+        arg != "--latency-sample-period") {
+      mbpArgv.push_back(argv[i]);
+      continue;
     }
-    if (instrNum >= stopAtInstr) break;
-    branchIps.insert(b.ip());
-    std::uint32_t bId = bp.get_new_branch_id();
-    rob[back].instrNum = instrNum;
-    rob[back].bId = bId;
-    rob[back].b = b;
-    back = back + 1 < rob.size() ? back + 1 : 0;
-    bool prediction = bp.get_prediction(bId, b.ip());
-    if (b.isConditional()) {
-      mispredicted = prediction != b.isTaken();
-      bp.update_speculative_state(bId, b.ip(), Type(b), prediction, b.target());
-      if (mispredicted) {
-        for (int i = 0; i < kNumWrongPathBranches; ++i) {
-          tagescl::Branch_Type rndType;
-          rndType.is_conditional = std::rand() % 2;
-          rndType.is_indirect = (std::rand() % 20) == 0;
-          std::uint64_t rndIp = b.ip() + std::rand();
-          std::uint64_t rndTgt = rndIp + std::rand();
-          std::uint32_t rndId = bp.get_new_branch_id();
-          bool rndPred = bp.get_prediction(rndId, rndIp);
-          bp.update_speculative_state(rndId, rndIp, rndType, rndPred, rndTgt);
-        }
-        bp.flush_branch_and_repair_state(bId, b.ip(), Type(b), b.isTaken(),
-                                         b.target());
-      }
-      if (instrNum >= warmupInstrs) {
-        numBranches += 1;
-        mispredictions += mispredicted;
+    if (i + 1 == argc) {
+      Usage("missing value for " + arg);
+    }
+    std::string value = argv[++i];
+    if (arg == "--threads") {
+      options.numThreads = ParseInt(value, arg);
+      continue;
+    }
+    if (arg == "--ring-capacity") {
+      options.ringCapacity = ParseInt(value, arg);
+      continue;
+    }
+    if (arg == "--batch") {
+      options.batchSize = ParseInt(value, arg);
+      continue;
+    }
+    if (arg == "--latency-sample-period") {
+      options.latencySamplePeriod = std::max(1, ParseInt(value, arg));
+      continue;
+    }
+    if (arg == "--config") {
+      if (LateCommitConfigs().count(value) == 0) {
+        Usage("unknown configuration " + value);
       }
-    } else {
-      bp.update_speculative_state(bId, b.ip(), Type(b), b.isTaken(),
-                                  b.target());
+      configs.push_back(value);
+      continue;
+    }
+    std::size_t colon = value.find(':');
+    if (colon == std::string::npos) {
+      Usage("expected C:W for " + arg);
     }
+    pipelines.emplace_back(ParseInt(value.substr(0, colon), arg),
+                           ParseInt(value.substr(colon + 1), arg));
+  }
+  if (configs.empty()) {
+    configs.push_back("64KB");
+  }
+  if (pipelines.empty()) {
+    pipelines.emplace_back(0, 0);
   }
+  mbpArgv.push_back(nullptr);
 
-  auto endTime = std::chrono::high_resolution_clock::now();
-  double simulationTime =
-      std::chrono::duration<double>(endTime - startTime).count();
-  // See Note 0.
-  std::int64_t metricInstr =
-      simInstr == 0 ? trace.numInstructions() - warmupInstrs : simInstr;
-  if (simInstr != 0 && trace.eof()) {
-    std::string errMsg = "The trace did not contain " +
-                         std::to_string(simInstr) + " instructions, only " +
-                         std::to_string(trace.lastInstrRead());
-    errors.emplace_back(errMsg);
+  const auto& [tracepath, warmupInstrs, simInstr, stopAtInstr] =
+      mbp::ParseCmdLineArgs(static_cast<int>(mbpArgv.size()) - 1,
+                            mbpArgv.data());
+  std::vector<SweepJob> jobs;
+  for (const auto& config : configs) {
+    for (const auto& [correctPathInstrs, wrongPathBranches] : pipelines) {
+      jobs.push_back({config, correctPathInstrs, wrongPathBranches});
+    }
+  }
+  LateCommitParams params = {tracepath,
+                             static_cast<std::int64_t>(warmupInstrs),
+                             static_cast<std::int64_t>(simInstr),
+                             static_cast<std::int64_t>(stopAtInstr),
+                             0,
+                             0};
+  if (options.numThreads == 0) {
+    options.numThreads = std::min<int>(
+        jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+  }
+  SweepResult result;
+  try {
+    result = LateCommitSweep(params, jobs, options);
+  } catch (const std::exception& e) {
+    std::cerr << "wrong_path_sim: " << e.what() << "\n";
+    return mbp::ERR_SIMULATION_ERROR;
+  }
+  std::vector<mbp::json>& reports = result.reports;
+  if (jobs.size() == 1) {
+    mbp::json& output = reports[0];
+    output["metadata"].erase("config");
+    std::cout << std::setw(2) << output << std::endl;
+    return output["errors"].empty() ? 0 : mbp::ERR_SIMULATION_ERROR;
   }
 
-  mbp::json j = {
+  // The trace errors are the same for every job.
+  mbp::json output = {
       {"metadata",
        {
-           {"simulator", "SBBT trace with late commit and wrong path."},
-           {"simulator_version", "v0.1.0"},
-           {"simulator_num_correct_path_instrs", kNumCorrectPathInstrs},
-           {"simulator_num_wrong_path_branches", kNumWrongPathBranches},
+           {"simulator", "SBBT trace with late commit and wrong path, sweep "
+                         "of configurations and pipelines."},
+           {"simulator_version", kLateCommitSimVersion},
            {"trace", tracepath},
-           {"warmup_instr", warmupInstrs},
-           {"simulation_instr", metricInstr},
-           {"exhausted_trace", trace.eof()},
-           {"num_conditonal_branches", numBranches},
-           {"num_branch_instructions", branchIps.size()},
-           {"predictor", {{"name", "Adapter of Scarab's TAGE-SC-L to MBPlib"}}},
-       }},
-      {"metrics",
-       {
-           {"mpki", 1000.0 * mispredictions / metricInstr},
-           {"mispredictions", mispredictions},
-           {"accuracy",
-            static_cast<double>(numBranches - mispredictions) / numBranches},
-           {"simulation_time", simulationTime},
+           {"num_jobs", jobs.size()},
+           {"num_threads", std::min<int>(options.numThreads, jobs.size())},
+           {"ring_capacity", options.ringCapacity},
+           {"batch_size", options.batchSize},
+           {"wall_time", result.wallTime},
        }},
-      {"predictor_statistics", {}},
-      {"errors", errors},
+      {"sweep", reports},
+      {"errors", reports[0]["errors"]},
   };
-  return j;
-}
-
-#if TAGE_SC_L_SIZE == 64
-static tagescl::Tage_SC_L<tagescl::CONFIG_64KB> branchPredictor(
-    kNumCorrectPathInstrs + kNumWrongPathBranches);
-#elif TAGE_SC_L_SIZE == 80
-static tagescl::Tage_SC_L<tagescl::CONFIG_80KB> branchPredictor(
-    kNumCorrectPathInstrs + kNumWrongPathBranches);
-#else
-#error Unsupported TAGE_SC_L_SIZE setting.
-#endif
-
-int main(int argc, char** argv) {
-  auto args = mbp::ParseCmdLineArgs(argc, argv);
-  mbp::json output = Sim(branchPredictor, args);
   std::cout << std::setw(2) << output << std::endl;
   return output["errors"].empty() ? 0 : mbp::ERR_SIMULATION_ERROR;
 }
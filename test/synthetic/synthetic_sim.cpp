@@ -0,0 +1,90 @@
+// Runs the predictor on a synthetic branch stream, without a trace, and
+// prints the results in the JSON format of the SBBT simulators.
+//
+// Usage: synthetic_tagescl_<size> [num_branches] [seed]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#include "tagescl/synthetic_stream.hpp"
+#include "tagescl/tagescl.hpp"
+
+template <class CONFIG>
+int Sim(tagescl::Tage_SC_L<CONFIG>& bp, std::int64_t numBranches,
+        const tagescl::Synthetic_Stream_Config& config) {
+  tagescl::Synthetic_Branch_Stream stream{config};
+  std::int64_t numConditional = 0;
+  std::int64_t mispredictions = 0;
+  auto startTime = std::chrono::high_resolution_clock::now();
+  for (std::int64_t i = 0; i < numBranches; ++i) {
+    tagescl::Branch_Record b = stream.next();
+    std::uint32_t bId = bp.get_new_branch_id();
+    bool prediction = bp.get_prediction(bId, b.br_pc);
+    if (b.br_type.is_conditional) {
+      bool mispredicted = prediction != b.resolve_dir;
+      numConditional += 1;
+      mispredictions += mispredicted;
+      bp.update_speculative_state(bId, b.br_pc, b.br_type, prediction,
+                                  b.br_target);
+      if (mispredicted) {
+        bp.flush_branch_and_repair_state(bId, b.br_pc, b.br_type,
+                                         b.resolve_dir, b.br_target);
+      }
+      bp.commit_state(bId, b.br_pc, b.br_type, b.resolve_dir);
+    } else {
+      bp.update_speculative_state(bId, b.br_pc, b.br_type, b.resolve_dir,
+                                  b.br_target);
+    }
+    bp.commit_state_at_retire(bId, b.br_pc, b.br_type, b.resolve_dir,
+                              b.br_target);
+  }
+  auto endTime = std::chrono::high_resolution_clock::now();
+  double simulationTime =
+      std::chrono::duration<double>(endTime - startTime).count();
+  std::int64_t numInstructions = stream.instruction_number();
+
+  std::cout << "{\n"
+            << "  \"metadata\": {\n"
+            << "    \"simulator\": \"Synthetic branch stream.\",\n"
+            << "    \"simulator_version\": \"v0.1.0\",\n"
+            << "    \"seed\": " << config.seed << ",\n"
+            << "    \"simulation_instr\": " << numInstructions << ",\n"
+            << "    \"num_branches\": " << numBranches << ",\n"
+            << "    \"num_conditonal_branches\": " << numConditional << ",\n"
+            << "    \"predictor\": {\"name\": \"Scarab's TAGE-SC-L\"}\n"
+            << "  },\n"
+            << "  \"metrics\": {\n"
+            << "    \"mpki\": " << 1000.0 * mispredictions / numInstructions
+            << ",\n"
+            << "    \"mispredictions\": " << mispredictions << ",\n"
+            << "    \"accuracy\": "
+            << static_cast<double>(numConditional - mispredictions) /
+                   numConditional
+            << ",\n"
+            << "    \"simulation_time\": " << simulationTime << "\n"
+            << "  },\n"
+            << "  \"predictor_statistics\": {},\n"
+            << "  \"errors\": []\n"
+            << "}" << std::endl;
+  return 0;
+}
+
+#if TAGE_SC_L_SIZE == 64
+static tagescl::Tage_SC_L<tagescl::CONFIG_64KB> branchPredictor(1);
+#elif TAGE_SC_L_SIZE == 80
+static tagescl::Tage_SC_L<tagescl::CONFIG_80KB> branchPredictor(1);
+#else
+#error Unsupported TAGE_SC_L_SIZE setting.
+#endif
+
+int main(int argc, char** argv) {
+  std::int64_t numBranches =
+      argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 10000000;
+  tagescl::Synthetic_Stream_Config config;
+  if (argc > 2) {
+    config.seed = std::strtoull(argv[2], nullptr, 10);
+  }
+  return Sim(branchPredictor, numBranches, config);
+}